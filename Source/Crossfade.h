@@ -0,0 +1,53 @@
+/*
+  ==============================================================================
+
+    Crossfade.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/*
+    The gains of the crossfade every moved read head goes through, the delay's
+    main and tap heads as well as the reverb's lines when their lengths change.
+    The new head comes in on a square law and the old one goes out linearly,
+    one gain per lane of each frame, so a fade can be applied to a whole
+    segment with two vector operations.
+*/
+namespace Crossfade
+{
+    // numFrames frames of a fade fadeCount frames into fadeLength
+    inline void renderGains (float* newGain, float* oldGain, int fadeCount, int fadeLength, int numFrames, int numLanes) noexcept
+    {
+        for (int j = 0; j < numFrames; ++j)
+        {
+            const float scale = (float) (fadeCount + 1 + j) / fadeLength;
+
+            for (int lane = 0; lane < numLanes; ++lane)
+            {
+                newGain[j * numLanes + lane] = scale * scale;
+                oldGain[j * numLanes + lane] = 1 - scale;
+            }
+        }
+    }
+
+    // the same for lanes each fadeCounts[lane] frames into a fade of their own
+    // fadeLengths[lane], a lane past the end of its fade only hears the new head
+    inline void renderLaneGains (float* newGain, float* oldGain, const int* fadeCounts, const int* fadeLengths,
+                                 int numFrames, int numLanes) noexcept
+    {
+        for (int lane = 0; lane < numLanes; ++lane)
+        {
+            for (int j = 0; j < numFrames; ++j)
+            {
+                const float scale = juce::jmin (1.0f, (float) (fadeCounts[lane] + 1 + j) / fadeLengths[lane]);
+                newGain[j * numLanes + lane] = scale * scale;
+                oldGain[j * numLanes + lane] = 1 - scale;
+            }
+        }
+    }
+}
@@ -0,0 +1,106 @@
+/*
+  ==============================================================================
+
+    DelayBufferAllocator.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/*
+    Builds delay buffers on a background thread so the audio thread can change
+    the maximum delay time without allocating.
+
+    The audio thread asks for a size with request(), picks the finished buffer
+    up with takePending() and hands the one it replaced back with retire(). The
+    thread frees retired buffers, and only builds a new one once the previous
+    one has been picked up and its predecessor freed, so each slot holds at
+    most one buffer.
+*/
+class DelayBufferAllocator : private juce::Thread
+{
+public:
+    DelayBufferAllocator() : juce::Thread ("DynamicDelay buffer allocator") {}
+
+    ~DelayBufferAllocator() override
+    {
+        stop();
+    }
+
+    static std::unique_ptr<juce::AudioSampleBuffer> allocate (int numChannels, int numSamples)
+    {
+        std::unique_ptr<juce::AudioSampleBuffer> buffer (new juce::AudioSampleBuffer (numChannels, numSamples));
+        buffer->clear();
+        return buffer;
+    }
+
+    // starts the thread, knowing the audio thread already holds a buffer of this size
+    void start (int numChannels, int numSamples)
+    {
+        stop();
+        built = requested = pack (numChannels, numSamples);
+        startThread();
+    }
+
+    void stop()
+    {
+        stopThread (2000);
+        delete pending.exchange (nullptr);
+        delete retired.exchange (nullptr);
+    }
+
+    //==============================================================================
+    // audio thread only
+    void request (int numChannels, int numSamples) noexcept
+    {
+        requested.store (pack (numChannels, numSamples));
+    }
+
+    juce::AudioSampleBuffer* takePending() noexcept
+    {
+        return pending.exchange (nullptr);
+    }
+
+    void retire (juce::AudioSampleBuffer* buffer) noexcept
+    {
+        jassert (retired.load() == nullptr);
+        retired.store (buffer);
+    }
+
+private:
+    // how often the thread looks for new requests and retired buffers
+    static constexpr int pollIntervalMs = 50;
+
+    std::atomic<juce::AudioSampleBuffer*> pending { nullptr }, retired { nullptr };
+    std::atomic<juce::int64> requested { 0 };
+    juce::int64 built = 0;
+
+    static juce::int64 pack (int numChannels, int numSamples) noexcept
+    {
+        return ((juce::int64) numChannels << 32) | (juce::int64) (juce::uint32) numSamples;
+    }
+
+    void run() override
+    {
+        while (! threadShouldExit())
+        {
+            delete retired.exchange (nullptr);
+
+            const juce::int64 spec = requested.load();
+
+            if (spec != built && pending.load() == nullptr && retired.load() == nullptr)
+            {
+                pending.store (allocate ((int) (spec >> 32), (int) (spec & 0xffffffff)).release());
+                built = spec;
+            }
+
+            wait (pollIntervalMs);
+        }
+    }
+
+    JUCE_DECLARE_NON_COPYABLE (DelayBufferAllocator)
+};
@@ -0,0 +1,126 @@
+/*
+  ==============================================================================
+
+    DelayBufferView.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "DelaySummary.h"
+
+//==============================================================================
+/*
+    Draws the delay line from the processor's DelaySummary, the whole line
+    from left to right with the write head and the main read head on top.
+
+    The waveform is kept in an image, a column per bucket. update() compares
+    the buckets with what was drawn last time and only draws the ones that
+    changed, which is mostly those the write head went through. A repaint is
+    the image plus two lines, however long the line is.
+*/
+class DelayBufferView  : public juce::Component
+{
+public:
+    explicit DelayBufferView (const DelaySummary& summaryToShow)
+        : summary (summaryToShow)
+    {
+        setOpaque (true);
+        setInterceptsMouseClicks (false, false);
+    }
+
+    // from the editor's timer
+    void update()
+    {
+        if (! waveform.isValid())
+            return;
+
+        const int numUsed = summary.getNumUsedBuckets();
+        bool changed = numUsed != numDrawnBuckets;
+        if (changed)
+        {
+            // a new line, every column is drawn again
+            numDrawnBuckets = numUsed;
+            juce::Graphics g (waveform);
+            g.fillAll (backgroundColour);
+            for (int b = 0; b < numDrawnBuckets; ++b)
+                drawBucket (g, b, summary.getMinimum (b), summary.getMaximum (b));
+        }
+        else
+        {
+            juce::Graphics g (waveform);
+            for (int b = 0; b < numDrawnBuckets; ++b)
+            {
+                const float low = summary.getMinimum (b), high = summary.getMaximum (b);
+                if (low != drawnMinimums[b] || high != drawnMaximums[b])
+                {
+                    drawBucket (g, b, low, high);
+                    changed = true;
+                }
+            }
+        }
+
+        const float write = summary.getWriteHead(), read = summary.getReadHead();
+        if (changed || write != drawnWriteHead || read != drawnReadHead)
+        {
+            drawnWriteHead = write;
+            drawnReadHead = read;
+            repaint();
+        }
+    }
+
+    void paint (juce::Graphics& g) override
+    {
+        g.drawImageAt (waveform, 0, 0);
+
+        const float height = (float) getHeight();
+        g.setColour (juce::Colours::orange);
+        g.drawVerticalLine (juce::roundToInt (drawnReadHead * (float) getWidth()), 0.0f, height);
+        g.setColour (juce::Colours::white);
+        g.drawVerticalLine (juce::roundToInt (drawnWriteHead * (float) getWidth()), 0.0f, height);
+    }
+
+    void resized() override
+    {
+        // a new size draws every column again on the next update
+        waveform = juce::Image (juce::Image::RGB, juce::jmax (1, getWidth()), juce::jmax (1, getHeight()), true);
+        numDrawnBuckets = 0;
+        update();
+    }
+
+private:
+    const DelaySummary& summary;
+    juce::Image waveform;
+    int numDrawnBuckets = 0;
+    float drawnMinimums[DelaySummary::numBuckets] = {};
+    float drawnMaximums[DelaySummary::numBuckets] = {};
+    float drawnWriteHead = 0.0f, drawnReadHead = 0.0f;
+
+    const juce::Colour backgroundColour { juce::Colours::darkgrey };
+
+    // the columns of the image that bucket b covers, full scale fills the height
+    void drawBucket (juce::Graphics& g, int bucket, float low, float high)
+    {
+        drawnMinimums[bucket] = low;
+        drawnMaximums[bucket] = high;
+
+        const int width = waveform.getWidth(), height = waveform.getHeight();
+        const int left = bucket * width / numDrawnBuckets;
+        const int right = juce::jmax (left + 1, (bucket + 1) * width / numDrawnBuckets);
+        const auto toY = [height] (float level)
+        {
+            return (int) std::floor ((0.5f - 0.5f * juce::jlimit (-1.0f, 1.0f, level)) * (float) (height - 1));
+        };
+
+        g.setColour (backgroundColour);
+        g.fillRect (left, 0, right - left, height);
+
+        const int top = toY (high), bottom = toY (low);
+        g.setColour (high > 1.0f || low < -1.0f ? juce::Colours::red : juce::Colours::limegreen);
+        g.fillRect (left, top, right - left, bottom - top + 1);
+    }
+
+    JUCE_DECLARE_NON_COPYABLE (DelayBufferView)
+};
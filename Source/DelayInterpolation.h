@@ -0,0 +1,229 @@
+/*
+  ==============================================================================
+
+    DelayInterpolation.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/*
+    Fractional delay kernels. Every kernel reads the four samples x[-1], x[0],
+    x[1] and x[2] around the read position x[0] + frac, and is given a pointer
+    to x[-1]. Consecutive samples are stride floats apart, which lets the same
+    kernels read a planar line (stride 1) or a channel-interleaved one.
+
+    process() reads a run of frames at a constant fraction, which is what the
+    delay does while the delay time is steady, so the FIR kernels turn into a
+    handful of vector operations over all lanes at once. processLanes() does
+    the same for lanes that each sit at a window and fraction of their own,
+    a lane at a time. interpolate() reads a single sample at any fraction.
+    state belongs to one read head, one value per lane, and is only used by
+    the allpass.
+*/
+namespace DelayInterpolation
+{
+    enum Type
+    {
+        linear = 0,
+        hermite,
+        lagrange,
+        allpass,
+        numTypes
+    };
+
+    // samples needed past the end of the delay line so a window never wraps
+    static constexpr int numGuardSamples = 3;
+
+    inline juce::StringArray getNames()
+    {
+        return { "linear", "cubic hermite", "lagrange", "allpass" };
+    }
+
+    // dest[j] = c[0] x[j-1] + c[1] x[j] + c[2] x[j+1] + c[3] x[j+2], with x[j] stride floats apart
+    inline void applyFir (const float* x, int stride, const float* c, float* dest, int numSamples) noexcept
+    {
+        bool first = true;
+
+        for (int t = 0; t < 4; ++t)
+        {
+            if (c[t] == 0.0f)
+                continue;
+
+            if (first)
+                juce::FloatVectorOperations::copyWithMultiply (dest, x + t * stride, c[t], numSamples);
+            else
+                juce::FloatVectorOperations::addWithMultiply (dest, x + t * stride, c[t], numSamples);
+
+            first = false;
+        }
+
+        if (first)
+            juce::FloatVectorOperations::clear (dest, numSamples);
+    }
+
+    inline float dot (const float* x, int stride, const float* c) noexcept
+    {
+        return c[0] * x[0] + c[1] * x[stride] + c[2] * x[2 * stride] + c[3] * x[3 * stride];
+    }
+
+    // dest[j * stride] for one lane, with x[j] stride floats apart
+    inline void applyFirToLane (const float* x, int stride, const float* c, float* dest, int numFrames) noexcept
+    {
+        for (int j = 0; j < numFrames; ++j)
+            dest[j * stride] = dot (x + j * stride, stride, c);
+    }
+
+    //==============================================================================
+    struct Linear
+    {
+        static void getCoefficients (float t, float* c) noexcept
+        {
+            c[0] = 0.0f;
+            c[1] = 1.0f - t;
+            c[2] = t;
+            c[3] = 0.0f;
+        }
+
+        static float interpolate (const float* x, int stride, float frac, float&) noexcept
+        {
+            return x[stride] + frac * (x[2 * stride] - x[stride]);
+        }
+
+        static void process (const float* x, float frac, float* dest, int numFrames, int numLanes, float*) noexcept
+        {
+            float c[4];
+            getCoefficients (frac, c);
+            applyFir (x, numLanes, c, dest, numFrames * numLanes);
+        }
+
+        static void processLane (const float* x, float frac, float* dest, int numFrames, int numLanes, float&) noexcept
+        {
+            float c[4];
+            getCoefficients (frac, c);
+            applyFirToLane (x, numLanes, c, dest, numFrames);
+        }
+    };
+
+    // 4-point, 3rd-order Hermite (Catmull-Rom)
+    struct Hermite
+    {
+        static void getCoefficients (float t, float* c) noexcept
+        {
+            c[0] = t * (-0.5f + t * (1.0f - 0.5f * t));
+            c[1] = 1.0f + t * t * (1.5f * t - 2.5f);
+            c[2] = t * (0.5f + t * (2.0f - 1.5f * t));
+            c[3] = 0.5f * t * t * (t - 1.0f);
+        }
+
+        static float interpolate (const float* x, int stride, float frac, float&) noexcept
+        {
+            float c[4];
+            getCoefficients (frac, c);
+            return dot (x, stride, c);
+        }
+
+        static void process (const float* x, float frac, float* dest, int numFrames, int numLanes, float*) noexcept
+        {
+            float c[4];
+            getCoefficients (frac, c);
+            applyFir (x, numLanes, c, dest, numFrames * numLanes);
+        }
+
+        static void processLane (const float* x, float frac, float* dest, int numFrames, int numLanes, float&) noexcept
+        {
+            float c[4];
+            getCoefficients (frac, c);
+            applyFirToLane (x, numLanes, c, dest, numFrames);
+        }
+    };
+
+    // 4-point, 3rd-order Lagrange
+    struct Lagrange
+    {
+        static void getCoefficients (float t, float* c) noexcept
+        {
+            const float tp1 = t + 1.0f, tm1 = t - 1.0f, tm2 = t - 2.0f;
+            c[0] = -t * tm1 * tm2 * (1.0f / 6.0f);
+            c[1] = tp1 * tm1 * tm2 * 0.5f;
+            c[2] = -tp1 * t * tm2 * 0.5f;
+            c[3] = tp1 * t * tm1 * (1.0f / 6.0f);
+        }
+
+        static float interpolate (const float* x, int stride, float frac, float&) noexcept
+        {
+            float c[4];
+            getCoefficients (frac, c);
+            return dot (x, stride, c);
+        }
+
+        static void process (const float* x, float frac, float* dest, int numFrames, int numLanes, float*) noexcept
+        {
+            float c[4];
+            getCoefficients (frac, c);
+            applyFir (x, numLanes, c, dest, numFrames * numLanes);
+        }
+
+        static void processLane (const float* x, float frac, float* dest, int numFrames, int numLanes, float&) noexcept
+        {
+            float c[4];
+            getCoefficients (frac, c);
+            applyFirToLane (x, numLanes, c, dest, numFrames);
+        }
+    };
+
+    /*  First-order allpass, y[n] = x[n-1] + eta * (x[n] - y[n-1]). The integer
+        part is picked so the allpass delay stays between 0.5 and 1.5 samples,
+        where it is best behaved. It is recursive, so it can't be vectorised.
+    */
+    struct Allpass
+    {
+        static float interpolate (const float* x, int stride, float frac, float& state) noexcept
+        {
+            const int offset = frac <= 0.5f ? 1 : 2;
+            const float d = (float) offset - frac;
+            const float eta = (1.0f - d) / (1.0f + d);
+            state = x[offset * stride] + eta * (x[(offset + 1) * stride] - state);
+            return state;
+        }
+
+        static void process (const float* x, float frac, float* dest, int numFrames, int numLanes, float* state) noexcept
+        {
+            for (int lane = 0; lane < numLanes; ++lane)
+                processLane (x + lane, frac, dest + lane, numFrames, numLanes, state[lane]);
+        }
+
+        static void processLane (const float* x, float frac, float* dest, int numFrames, int numLanes, float& state) noexcept
+        {
+            const int offset = frac <= 0.5f ? 1 : 2;
+            const float d = (float) offset - frac;
+            const float eta = (1.0f - d) / (1.0f + d);
+            const float* xl = x + offset * numLanes;
+            float y = state;
+
+            for (int j = 0; j < numFrames; ++j)
+            {
+                y = xl[j * numLanes] + eta * (xl[(j + 1) * numLanes] - y);
+                dest[j * numLanes] = y;
+            }
+
+            state = y;
+        }
+    };
+
+    //==============================================================================
+    /*  Reads numFrames frames of numLanes lanes, each lane from the window that
+        starts windows[lane] frames into line and at fractions[lane].
+    */
+    template <typename Kernel>
+    inline void processLanes (const float* line, const int* windows, const float* fractions, float* dest,
+                              int numFrames, int numLanes, float* state) noexcept
+    {
+        for (int lane = 0; lane < numLanes; ++lane)
+            Kernel::processLane (line + windows[lane] * numLanes + lane, fractions[lane], dest + lane, numFrames, numLanes, state[lane]);
+    }
+}
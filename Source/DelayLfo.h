@@ -0,0 +1,179 @@
+/*
+  ==============================================================================
+
+    DelayLfo.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/*
+    Moves the main read head back and forth for chorus, flanger and vibrato.
+    It is rendered a chunk at a time as read offsets, in samples behind the
+    head's unmodulated position, so the delay swings between its set time and
+    that time plus the depth. Each channel runs phaseOffset cycles ahead of
+    the one before.
+
+    There is no std::sin per sample. The sine is a fifth-order polynomial on
+    a triangle wave, within 4e-4 of it and exactly flat at the peaks, so it
+    has no kink where the triangle turns. The random shape glides between
+    values hashed from the cycle count. Every sample is worked out from the
+    phase alone, so each loop can be vectorised. Depth changes are ramped
+    over rampLength samples, the head never jumps unless the depth has to be
+    cut to keep it inside the line.
+*/
+class DelayLfo
+{
+public:
+    DelayLfo() = default;
+
+    enum Shapes
+    {
+        sine = 0,
+        triangle,
+        randomSmooth
+    };
+
+    static juce::StringArray getNames()
+    {
+        return { "Sine", "Triangle", "Random" };
+    }
+
+    void prepare (double newSampleRate, int newRampLength) noexcept
+    {
+        sampleRate = newSampleRate;
+        rampLength = juce::jmax (1, newRampLength);
+        depth = targetDepth = depthStep = 0.0f;
+        reset();
+    }
+
+    // back to the start of the first cycle
+    void reset() noexcept
+    {
+        phase = 0.0;
+        cycle = 0;
+    }
+
+    void setShape (int newShape) noexcept             { shape = newShape; }
+    void setRate (float hertz) noexcept               { increment = (double) hertz / sampleRate; }
+    void setPhaseOffset (float cycles) noexcept       { phaseOffset = cycles; }
+
+    /*  The depth in samples is ramped to newDepth, but never goes past limit,
+        the most the head can be moved back before it leaves the line.
+    */
+    void setDepth (float newDepth, float limit) noexcept
+    {
+        depthLimit = juce::jmax (0.0f, limit);
+        depth = juce::jmin (depth, depthLimit);
+        if (newDepth != targetDepth || (depthStep == 0.0f && depth != targetDepth))
+        {
+            targetDepth = newDepth;
+            depthStep = (targetDepth - depth) / (float) rampLength;
+        }
+    }
+
+    bool isActive() const noexcept                    { return depth > 0.0f || targetDepth > 0.0f; }
+    float getTargetDepth() const noexcept             { return targetDepth; }
+
+    /*  Writes the offsets of numFrames frames into dest, a frame of numLanes
+        channels at a time starting with firstChannel, like the delay store.
+        It doesn't move the LFO on, so each pass over a chunk can render its
+        own channels, and advance() is called once they all have.
+    */
+    void render (float* dest, int numFrames, int firstChannel, int numLanes) const noexcept
+    {
+        for (int lane = 0; lane < numLanes; ++lane)
+        {
+            double start = phase + (double) phaseOffset * (firstChannel + lane);
+            const double whole = std::floor (start);
+            start -= whole;
+            const juce::uint32 firstCycle = cycle + (juce::uint32) (juce::int64) whole;
+            const juce::uint32 seed = (juce::uint32) (firstChannel + lane) * 0x85ebca77u;
+            const float p0 = (float) start, inc = (float) increment;
+            float* out = dest + lane;
+
+            if (shape == randomSmooth)
+            {
+                for (int j = 0; j < numFrames; ++j)
+                {
+                    const float p = p0 + inc * (float) j;
+                    const float f = std::floor (p);
+                    const float t = p - f;
+                    const juce::uint32 k = firstCycle + (juce::uint32) (int) f;
+                    const float a = hashToUnit (k ^ seed), b = hashToUnit ((k + 1) ^ seed);
+                    out[j * numLanes] = a + (b - a) * t * t * (3.0f - 2.0f * t);
+                }
+            }
+            else
+            {
+                // a triangle through 0 at the start of the cycle, 1 a quarter in
+                for (int j = 0; j < numFrames; ++j)
+                {
+                    const float p = p0 + inc * (float) j + 0.25f;
+                    out[j * numLanes] = 1.0f - 4.0f * std::abs (p - std::floor (p) - 0.5f);
+                }
+
+                // sin (pi / 2 t) for t from -1 to 1, the slope matched at 0 and 1
+                if (shape == sine)
+                {
+                    for (int j = 0; j < numFrames; ++j)
+                    {
+                        const float t = out[j * numLanes];
+                        const float t2 = t * t;
+                        out[j * numLanes] = t * (1.5707963f + t2 * (-0.6415927f + t2 * 0.0707963f));
+                    }
+                }
+            }
+
+            // from the unit swing to samples behind the head, ramping the depth
+            for (int j = 0; j < numFrames; ++j)
+            {
+                float d = depth + depthStep * (float) (j + 1);
+                d = depthStep > 0.0f ? juce::jmin (d, targetDepth) : juce::jmax (d, targetDepth);
+                out[j * numLanes] = juce::jmin (d, depthLimit) * 0.5f * (1.0f + out[j * numLanes]);
+            }
+        }
+    }
+
+    void advance (int numFrames) noexcept
+    {
+        phase += increment * numFrames;
+        const double whole = std::floor (phase);
+        cycle += (juce::uint32) (juce::int64) whole;
+        phase -= whole;
+
+        depth += depthStep * (float) numFrames;
+        depth = depthStep > 0.0f ? juce::jmin (depth, targetDepth) : juce::jmax (depth, targetDepth);
+        depth = juce::jmin (depth, depthLimit);
+        if (depth == targetDepth)
+            depthStep = 0.0f;
+    }
+
+private:
+    double sampleRate = 44100.0;
+    int rampLength = 1;
+    int shape = sine;
+    double increment = 0.0;
+    float phaseOffset = 0.0f;
+    float depth = 0.0f, targetDepth = 0.0f, depthStep = 0.0f, depthLimit = 0.0f;
+
+    // where the first channel is, whole cycles are counted apart for the random shape
+    double phase = 0.0;
+    juce::uint32 cycle = 0;
+
+    // a value from -1 to 1 for every cycle
+    static float hashToUnit (juce::uint32 x) noexcept
+    {
+        x *= 0x9e3779b1u;
+        x ^= x >> 15;
+        x *= 0x2c1b3c6du;
+        x ^= x >> 12;
+        x *= 0x297a2d39u;
+        x ^= x >> 15;
+        return (float) x * (2.0f / 4294967296.0f) - 1.0f;
+    }
+};
@@ -0,0 +1,110 @@
+/*
+  ==============================================================================
+
+    DelaySummary.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/*
+    A picture of the delay line for the editor, a minimum and maximum per
+    bucket of bucketSize frames, across every channel. The audio thread folds
+    each run it writes into the buckets it covers, so the editor never has to
+    read the delay buffer itself, which could be 60 s long and swapped out
+    from under it.
+
+    The buckets are fixed in number and plain atomics, the audio thread never
+    locks or allocates. A bucket the write head is crossing shows the new
+    samples written into it so far.
+*/
+class DelaySummary
+{
+public:
+    DelaySummary() = default;
+
+    static constexpr int numBuckets = 512;
+
+    // audio thread, for a silent line of lineLength frames
+    void reset (int lineLength) noexcept
+    {
+        length = juce::jmax (1, lineLength);
+        bucketSize = (length + numBuckets - 1) / numBuckets;
+
+        for (int b = 0; b < numBuckets; ++b)
+        {
+            minimums[b].store (0.0f, std::memory_order_relaxed);
+            maximums[b].store (0.0f, std::memory_order_relaxed);
+        }
+
+        numUsedBuckets.store ((length + bucketSize - 1) / bucketSize);
+        writeHead.store (0.0f);
+        readHead.store (0.0f);
+    }
+
+    /*  Audio thread, after numFrames frames of numLanes samples were written
+        to the line from position on, without wrapping. A planar store calls
+        this for each of its lines in turn, firstLine set for the first, and
+        the others widen what it left in the buckets.
+    */
+    void add (const float* data, int position, int numFrames, int numLanes, bool firstLine) noexcept
+    {
+        while (numFrames > 0)
+        {
+            const int bucket = position / bucketSize;
+            const int bucketStart = bucket * bucketSize;
+            const int n = juce::jmin (numFrames, bucketStart + bucketSize - position);
+            const juce::Range<float> range = juce::FloatVectorOperations::findMinAndMax (data, n * numLanes);
+
+            // the head starting a bucket again is the end of what it held
+            float low = range.getStart(), high = range.getEnd();
+            if (! (firstLine && position == bucketStart))
+            {
+                low = juce::jmin (low, minimums[bucket].load (std::memory_order_relaxed));
+                high = juce::jmax (high, maximums[bucket].load (std::memory_order_relaxed));
+            }
+
+            minimums[bucket].store (low, std::memory_order_relaxed);
+            maximums[bucket].store (high, std::memory_order_relaxed);
+
+            data += n * numLanes;
+            position += n;
+            numFrames -= n;
+        }
+    }
+
+    // audio thread, where the write head and the main read head are
+    void setHeads (int writePosition, double delaySamples) noexcept
+    {
+        const float write = (float) writePosition / (float) length;
+        float read = write - (float) (delaySamples / length);
+        if (read < 0.0f)
+            read += 1.0f;
+
+        writeHead.store (write);
+        readHead.store (read);
+    }
+
+    // the rest is for the editor, buckets from numUsedBuckets on are unused
+    int getNumUsedBuckets() const noexcept       { return numUsedBuckets.load(); }
+    float getMinimum (int bucket) const noexcept { return minimums[bucket].load (std::memory_order_relaxed); }
+    float getMaximum (int bucket) const noexcept { return maximums[bucket].load (std::memory_order_relaxed); }
+
+    // as fractions of the line, from 0 at its start to 1 at its end
+    float getWriteHead() const noexcept          { return writeHead.load(); }
+    float getReadHead() const noexcept           { return readHead.load(); }
+
+private:
+    int length = 1;
+    int bucketSize = 1;
+    std::atomic<int> numUsedBuckets { 1 };
+    std::atomic<float> minimums[numBuckets] {};
+    std::atomic<float> maximums[numBuckets] {};
+    std::atomic<float> writeHead { 0.0f }, readHead { 0.0f };
+
+    JUCE_DECLARE_NON_COPYABLE (DelaySummary)
+};
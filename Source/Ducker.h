@@ -0,0 +1,101 @@
+/*
+  ==============================================================================
+
+    Ducker.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/*
+    Turns the wet signal down while a key signal is playing, the input or a
+    sidechain. An envelope follower with separate attack and release runs on
+    the loudest key channel, and the wet gain falls with the envelope until
+    it reaches referenceLevel, where the full amount is taken off.
+
+    Only the envelope is worked out sample by sample, the rectifying and the
+    mapping to a gain are whole-vector operations over the block, so the
+    whole thing costs a few operations per sample.
+*/
+class Ducker
+{
+public:
+    Ducker() = default;
+
+    void prepare (double newSampleRate) noexcept
+    {
+        sampleRate = newSampleRate;
+        reset();
+        setTimes (attackSeconds, releaseSeconds);
+    }
+
+    void reset() noexcept
+    {
+        envelope = 0.0f;
+    }
+
+    // amount goes from 0, which leaves the wet signal alone, to 1, which takes all of it off
+    void setAmount (float newAmount) noexcept   { amount = newAmount; }
+    bool isActive() const noexcept              { return amount > 0.0f; }
+
+    void setTimes (float newAttackSeconds, float newReleaseSeconds) noexcept
+    {
+        attackSeconds = newAttackSeconds;
+        releaseSeconds = newReleaseSeconds;
+        attack = getCoefficient (attackSeconds);
+        release = getCoefficient (releaseSeconds);
+    }
+
+    /*  Writes numSamples wet gains into gains, following numKeyChannels
+        channels of key signal.
+    */
+    void process (const float* const* key, int numKeyChannels, float* gains, int numSamples) noexcept
+    {
+        if (numKeyChannels == 0)
+        {
+            juce::FloatVectorOperations::clear (gains, numSamples);
+        }
+        else
+        {
+            juce::FloatVectorOperations::abs (gains, key[0], numSamples);
+            for (int channel = 1; channel < numKeyChannels; ++channel)
+                for (int j = 0; j < numSamples; ++j)
+                    gains[j] = juce::jmax (gains[j], std::abs (key[channel][j]));
+        }
+
+        float level = envelope;
+        for (int j = 0; j < numSamples; ++j)
+        {
+            const float x = gains[j];
+            level += (x > level ? attack : release) * (x - level);
+            gains[j] = level;
+        }
+        envelope = level;
+
+        // 1 - amount * min (1, envelope / referenceLevel)
+        juce::FloatVectorOperations::multiply (gains, amount / referenceLevel, numSamples);
+        juce::FloatVectorOperations::min (gains, gains, amount, numSamples);
+        juce::FloatVectorOperations::negate (gains, gains, numSamples);
+        juce::FloatVectorOperations::add (gains, 1.0f, numSamples);
+    }
+
+private:
+    // a key at -20 dBFS or above takes the full amount off
+    static constexpr float referenceLevel = 0.1f;
+
+    double sampleRate = 44100.0;
+    float attackSeconds = 0.01f, releaseSeconds = 0.25f;
+    float attack = 1.0f, release = 1.0f;
+    float amount = 0.0f;
+    float envelope = 0.0f;
+
+    // the one-pole step that gets about two thirds of the way in the given time
+    float getCoefficient (float seconds) const noexcept
+    {
+        return (float) (1.0 - std::exp (-1.0 / (juce::jmax (1.0e-4, (double) seconds) * sampleRate)));
+    }
+};
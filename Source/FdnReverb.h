@@ -0,0 +1,348 @@
+/*
+  ==============================================================================
+
+    FdnReverb.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "Crossfade.h"
+
+//==============================================================================
+/*
+    A feedback delay network reverb, run next to the delay on the mono sum of
+    its input. It has 8 or 16 lines of different prime lengths, so no two of
+    them share a period, and their outputs are mixed back into their inputs
+    by a Hadamard matrix, in log2 N butterfly stages, or a Householder one.
+    Both are orthogonal, so the decay is set only by each line's gain.
+
+    Like the delay loop it runs over segments shorter than the shortest line,
+    where no sample is read after being written, with every step a whole
+    vector operation across the segment. A new size changes the lengths with
+    the same crossfade as the delay's read head, the old lengths fading out
+    over the cross time. As there, a size change while one is fading waits
+    for it to finish.
+*/
+class FdnReverb
+{
+public:
+    FdnReverb() = default;
+
+    enum Networks
+    {
+        off = 0,
+        hadamard8,
+        hadamard16,
+        householder8,
+        householder16
+    };
+
+    static constexpr int maxNumLines = 16;
+
+    static juce::StringArray getNames()
+    {
+        return { "Off", "8 lines Hadamard", "16 lines Hadamard", "8 lines Householder", "16 lines Householder" };
+    }
+
+    void prepare (double newSampleRate, int numChannelsToUse, int maxBlockSizeToUse)
+    {
+        sampleRate = newSampleRate;
+        numChannels = juce::jmax (1, numChannelsToUse);
+        maxBlockSize = juce::jmax (1, maxBlockSizeToUse);
+
+        // room for the longest line at the largest size, and the prime above it
+        lineCapacity = (int) (longestLineSeconds * sampleRate) + 64;
+        lines.setSize (maxNumLines, lineCapacity);
+        lineScratch.setSize (maxNumLines, maxBlockSize);
+        workScratch.setSize (numWorkScratchChannels, maxBlockSize);
+        output.setSize (numChannels, maxBlockSize);
+
+        network = off;
+        numLines = 0;
+        size = -1.0f;
+        reset();
+    }
+
+    // silences the lines and drops any crossfade
+    void reset() noexcept
+    {
+        lines.clear();
+        writePosition = 0;
+        fading = false;
+        fadeCount = 0;
+    }
+
+    // a change of the number of lines starts them out silent
+    void setNetwork (int newNetwork) noexcept
+    {
+        if (newNetwork == network)
+            return;
+
+        const int newNumLines = getNumLines (newNetwork);
+        if (newNumLines != numLines)
+        {
+            numLines = newNumLines;
+            reset();
+            size = -1.0f;
+        }
+
+        network = newNetwork;
+        updateGains();
+    }
+
+    bool isActive() const noexcept      { return network != off; }
+    bool isFading() const noexcept      { return fading; }
+
+    /*  size goes from 0 to 1, the lines are a fifth as long at 0. A change
+        fades over crossCount samples, unless the lines are new.
+    */
+    void setSize (float newSize, int crossCount) noexcept
+    {
+        if (newSize == size || fading || numLines == 0)
+            return;
+
+        const bool fade = size >= 0.0f;
+        for (int line = 0; line < numLines; ++line)
+            oldLengths[line] = lengths[line];
+
+        size = newSize;
+        const double scale = 0.2 + 0.8 * (double) size;
+        for (int line = 0; line < numLines; ++line)
+        {
+            // spread evenly on a log scale between the shortest and the longest line
+            const double seconds = shortestLineSeconds * std::pow (longestLineSeconds / shortestLineSeconds, (double) line / (numLines - 1));
+            int length = juce::jmax (2, (int) (seconds * scale * sampleRate));
+            while (! isPrime (length) || isUsed (length, line))
+                ++length;
+            lengths[line] = juce::jmin (length, lineCapacity - 1);
+        }
+
+        fading = fade;
+        fadeCount = 0;
+        fadeLength = juce::jmax (1, crossCount);
+        updateGains();
+    }
+
+    // the time the tail takes to fall by 60 dB
+    void setDecay (float seconds) noexcept
+    {
+        if (seconds != decaySeconds)
+        {
+            decaySeconds = seconds;
+            updateGains();
+        }
+    }
+
+    static int getNumLines (int network) noexcept
+    {
+        return network == off ? 0 : (network == hadamard16 || network == householder16 ? 16 : 8);
+    }
+
+    /*  How long the tail of an input that peaked at peak takes to fall below
+        threshold, with the decay time given in seconds. Works from parameter
+        values, so it can be asked from any thread.
+    */
+    static double getTailSeconds (int network, double decay, double peak, double threshold) noexcept
+    {
+        if (network == off || peak <= threshold)
+            return 0.0;
+
+        // a single line can hold the whole level of the network
+        const double loopPeak = peak * std::sqrt ((double) getNumLines (network));
+        return decay * juce::Decibels::gainToDecibels (loopPeak / threshold) / 60.0 + longestLineSeconds;
+    }
+
+    /*  Runs numFrames mono input samples through the network, into an output
+        per channel, see getOutput(). numFrames is at most the block size
+        given to prepare().
+    */
+    void process (const float* input, int numFrames) noexcept
+    {
+        for (int done = 0; done < numFrames;)
+        {
+            int n = numFrames - done;
+            for (int line = 0; line < numLines; ++line)
+            {
+                n = juce::jmin (n, lengths[line]);
+                if (fading)
+                    n = juce::jmin (n, oldLengths[line]);
+            }
+
+            processSegment (input + done, done, n);
+            done += n;
+        }
+    }
+
+    const float* getOutput (int channel) const noexcept     { return output.getReadPointer (channel); }
+
+private:
+    // the lines' lengths at the largest size, the shorter ones fill up the early part
+    static constexpr double shortestLineSeconds = 0.011;
+    static constexpr double longestLineSeconds = 0.097;
+
+    enum WorkScratchChannels
+    {
+        oldReadScratch = 0,
+        newGainScratch,
+        oldGainScratch,
+        sumScratch,
+        numWorkScratchChannels
+    };
+
+    double sampleRate = 44100.0;
+    int numChannels = 1;
+    int maxBlockSize = 1;
+    int lineCapacity = 1;
+    juce::AudioSampleBuffer lines, lineScratch, workScratch, output;
+
+    int network = off;
+    int numLines = 0;
+    float size = -1.0f;
+    float decaySeconds = 2.0f;
+    int lengths[maxNumLines] = {};
+    int oldLengths[maxNumLines] = {};
+    float gains[maxNumLines] = {};
+    int writePosition = 0;
+    bool fading = false;
+    int fadeCount = 0, fadeLength = 1;
+
+    static bool isPrime (int n) noexcept
+    {
+        if (n < 2)
+            return false;
+
+        for (int d = 2; d * d <= n; ++d)
+            if (n % d == 0)
+                return false;
+
+        return true;
+    }
+
+    bool isUsed (int length, int numBefore) const noexcept
+    {
+        for (int line = 0; line < numBefore; ++line)
+            if (lengths[line] == length)
+                return true;
+
+        return false;
+    }
+
+    void updateGains() noexcept
+    {
+        // every trip through a line of length L takes L samples off the decay,
+        // and the Hadamard stages grow the level by sqrt (N) without scaling
+        const float mixGain = network == hadamard8 || network == hadamard16 ? 1.0f / std::sqrt ((float) numLines) : 1.0f;
+
+        for (int line = 0; line < numLines; ++line)
+            gains[line] = mixGain * (float) std::pow (10.0, -3.0 * lengths[line] / (juce::jmax (0.01f, decaySeconds) * sampleRate));
+    }
+
+    void readLine (int line, int length, float* dest, int numFrames) const noexcept
+    {
+        int position = writePosition - length;
+        if (position < 0)
+            position += lineCapacity;
+
+        const float* data = lines.getReadPointer (line);
+        const int first = juce::jmin (numFrames, lineCapacity - position);
+        juce::FloatVectorOperations::copy (dest, data + position, first);
+        juce::FloatVectorOperations::copy (dest + first, data, numFrames - first);
+    }
+
+    void writeLine (int line, const float* source, int numFrames) noexcept
+    {
+        float* data = lines.getWritePointer (line);
+        const int first = juce::jmin (numFrames, lineCapacity - writePosition);
+        juce::FloatVectorOperations::copy (data + writePosition, source, first);
+        juce::FloatVectorOperations::copy (data, source + first, numFrames - first);
+    }
+
+    void processSegment (const float* input, int outputStart, int n) noexcept
+    {
+        float* x[maxNumLines];
+        for (int line = 0; line < numLines; ++line)
+        {
+            x[line] = lineScratch.getWritePointer (line);
+            readLine (line, lengths[line], x[line], n);
+        }
+
+        if (fading)
+        {
+            const int numFading = juce::jmin (n, fadeLength - fadeCount);
+            float* oldData = workScratch.getWritePointer (oldReadScratch);
+            float* newGain = workScratch.getWritePointer (newGainScratch);
+            float* oldGain = workScratch.getWritePointer (oldGainScratch);
+            Crossfade::renderGains (newGain, oldGain, fadeCount, fadeLength, numFading, 1);
+
+            for (int line = 0; line < numLines; ++line)
+            {
+                readLine (line, oldLengths[line], oldData, numFading);
+                juce::FloatVectorOperations::multiply (x[line], newGain, numFading);
+                juce::FloatVectorOperations::addWithMultiply (x[line], oldData, oldGain, numFading);
+            }
+
+            fadeCount += numFading;
+            if (fadeCount >= fadeLength)
+                fading = false;
+        }
+
+        // the lines are spread over the channels, with alternating signs
+        const int numOutputs = juce::jmin (numChannels, numLines);
+        const float outputGain = std::sqrt ((float) numOutputs / (float) numLines);
+        for (int channel = 0; channel < numOutputs; ++channel)
+        {
+            float* out = output.getWritePointer (channel, outputStart);
+            juce::FloatVectorOperations::clear (out, n);
+            for (int line = channel; line < numLines; line += numOutputs)
+                juce::FloatVectorOperations::addWithMultiply (out, x[line], (line / numOutputs) % 2 == 0 ? outputGain : -outputGain, n);
+        }
+        for (int channel = numOutputs; channel < numChannels; ++channel)
+            juce::FloatVectorOperations::copy (output.getWritePointer (channel, outputStart), output.getReadPointer (channel % numOutputs, outputStart), n);
+
+        // the mixing matrix, across the lines for every frame of the segment at once
+        float* temp = workScratch.getWritePointer (sumScratch);
+        if (network == hadamard8 || network == hadamard16)
+        {
+            for (int half = 1; half < numLines; half *= 2)
+            {
+                for (int start = 0; start < numLines; start += 2 * half)
+                {
+                    for (int line = start; line < start + half; ++line)
+                    {
+                        float* a = x[line];
+                        float* b = x[line + half];
+                        juce::FloatVectorOperations::copy (temp, a, n);
+                        juce::FloatVectorOperations::add (a, b, n);
+                        juce::FloatVectorOperations::subtract (b, temp, b, n);
+                    }
+                }
+            }
+        }
+        else
+        {
+            juce::FloatVectorOperations::copy (temp, x[0], n);
+            for (int line = 1; line < numLines; ++line)
+                juce::FloatVectorOperations::add (temp, x[line], n);
+            for (int line = 0; line < numLines; ++line)
+                juce::FloatVectorOperations::addWithMultiply (x[line], temp, -2.0f / (float) numLines, n);
+        }
+
+        // the input goes into every line, with alternating signs
+        const float inputGain = 1.0f / std::sqrt ((float) numLines);
+        for (int line = 0; line < numLines; ++line)
+        {
+            juce::FloatVectorOperations::multiply (x[line], gains[line], n);
+            juce::FloatVectorOperations::addWithMultiply (x[line], input, line % 2 == 0 ? inputGain : -inputGain, n);
+            writeLine (line, x[line], n);
+        }
+
+        writePosition += n;
+        if (writePosition >= lineCapacity)
+            writePosition -= lineCapacity;
+    }
+
+    JUCE_DECLARE_NON_COPYABLE (FdnReverb)
+};
@@ -0,0 +1,238 @@
+/*
+  ==============================================================================
+
+    FeedbackDrive.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/*
+    The drive stage of the feedback loop, a soft clipper run at a multiple of
+    the sample rate so the harmonics it adds above Nyquist are filtered off
+    instead of folding back into the repeats. The oversampling is JUCE's
+    polyphase IIR half-band filters, with their latency rounded to whole samples.
+
+    Only the feedback goes through it, never the input. Every channel has an
+    oversampler per factor, all built in prepare(), so the factor can change
+    on the audio thread. What process() adds to the line went in getLatency()
+    samples earlier, the processor has it added that far behind the write
+    head, where only the input has been written so far, so the loop keeps its
+    length, see processDelayLine().
+*/
+class FeedbackDrive
+{
+public:
+    FeedbackDrive() = default;
+
+    // 1x runs the curve at the sample rate, without latency but with aliasing
+    static constexpr int numOversamplingFactors = 4;
+
+    static juce::StringArray getOversamplingNames()
+    {
+        return { "1x", "2x", "4x", "8x" };
+    }
+
+    void prepare (int numChannelsToUse, int maxBlockSizeToUse)
+    {
+        numChannels = numChannelsToUse;
+        maxBlockSize = juce::jmax (1, maxBlockSizeToUse);
+        oversamplers.clear();
+        framesToSkip.calloc ((size_t) juce::jmax (1, numChannels));
+
+        for (int factor = 0; factor < numOversamplingFactors; ++factor)
+        {
+            for (int channel = 0; channel < numChannels; ++channel)
+            {
+                juce::dsp::Oversampling<float>* oversampler
+                    = new juce::dsp::Oversampling<float> (1, (size_t) factor, juce::dsp::Oversampling<float>::filterHalfBandPolyphaseIIR,
+                                                          true, true);
+                oversampler->initProcessing ((size_t) maxBlockSize);
+                oversamplers.add (oversampler);
+            }
+
+            latencies[factor] = numChannels > 0 ? (int) oversamplers.getLast()->getLatencyInSamples() : 0;
+        }
+    }
+
+    void reset() noexcept
+    {
+        for (juce::dsp::Oversampling<float>* oversampler : oversamplers)
+            oversampler->reset();
+    }
+
+    void setOversampling (int index) noexcept   { factorIndex = juce::jlimit (0, numOversamplingFactors - 1, index); }
+    int getOversampling() const noexcept        { return factorIndex; }
+
+    // in samples at the sample rate
+    int getLatency() const noexcept             { return latencies[factorIndex]; }
+    int getMaxLatency() const noexcept          { return juce::jmax (latencies[0], latencies[1], latencies[2], latencies[3]); }
+
+    /*  Drives numFrames frames of numLanes samples from source and adds them
+        to dest, lane by lane through the oversamplers of channel firstChannel
+        onwards. dest must not overlap source. scratch holds numFrames floats.
+    */
+    void process (const float* source, float* dest, int numFrames, int numLanes, int firstChannel,
+                  float drive, float* scratch) noexcept
+    {
+        if (numLanes == 1)
+        {
+            processChannel (firstChannel, source, scratch, numFrames, drive);
+            addToLane (firstChannel, scratch, dest, numFrames, 1);
+            return;
+        }
+
+        for (int lane = 0; lane < numLanes; ++lane)
+        {
+            for (int j = 0; j < numFrames; ++j)
+                scratch[j] = source[j * numLanes + lane];
+
+            processChannel (firstChannel + lane, scratch, scratch, numFrames, drive);
+            addToLane (firstChannel + lane, scratch, dest + lane, numFrames, numLanes);
+        }
+    }
+
+    /*  Starts the oversamplers of channel firstChannel onwards over again, on
+        gain times the frames of a circular line just before position ends[lane]
+        of each lane, so they take up without a transient. The processor hands
+        it the frames behind each channel's read head and the feedback gain, the loop's last input but
+        for the filters. The output is thrown away, and so are the first
+        getLatency() frames process() makes after it, they belong to frames
+        the line already has in full.
+    */
+    void prime (const float* line, int lineLength, const int* ends, int numLanes, int firstChannel,
+                float gain, float drive, float* scratch) noexcept
+    {
+        const int numFrames = juce::jmin (lineLength - 1, getLatency() + numPrimingFrames);
+
+        for (int lane = 0; lane < numLanes; ++lane)
+        {
+            getOversampler (firstChannel + lane).reset();
+            framesToSkip[firstChannel + lane] = getLatency();
+
+            for (int done = 0; done < numFrames;)
+            {
+                int position = ends[lane] - numFrames + done;
+                if (position < 0)
+                    position += lineLength;
+
+                const int n = juce::jmin (numFrames - done, lineLength - position, maxBlockSize);
+
+                for (int j = 0; j < n; ++j)
+                    scratch[j] = line[(position + j) * numLanes + lane] * gain;
+
+                processChannel (firstChannel + lane, scratch, scratch, n, drive);
+                done += n;
+            }
+        }
+    }
+
+    /*  Adds what the oversamplers of channel firstChannel onwards still owe to
+        the getLatency() frames of a circular line before position end, by
+        running silence through them. Called when the drive stops or changes
+        factor, so those frames get their feedback.
+    */
+    void flush (float* line, int lineLength, int end, int numLanes, int firstChannel,
+                float drive, float* scratch) noexcept
+    {
+        const int numFrames = getLatency();
+
+        for (int lane = 0; lane < numLanes; ++lane)
+        {
+            for (int done = 0; done < numFrames;)
+            {
+                const int n = juce::jmin (numFrames - done, maxBlockSize);
+                juce::FloatVectorOperations::clear (scratch, n);
+                processChannel (firstChannel + lane, scratch, scratch, n, drive);
+
+                int& skip = framesToSkip[firstChannel + lane];
+                const int skipped = juce::jmin (skip, n);
+                skip -= skipped;
+
+                for (int j = skipped; j < n; ++j)
+                {
+                    int position = end - numFrames + done + j;
+                    if (position < 0)
+                        position += lineLength;
+                    line[position * numLanes + lane] += scratch[j];
+                }
+
+                done += n;
+            }
+        }
+    }
+
+private:
+    // frames fed in on top of the latency before the output counts
+    static constexpr int numPrimingFrames = 64;
+
+    juce::OwnedArray<juce::dsp::Oversampling<float>> oversamplers;
+    int latencies[numOversamplingFactors] = {};
+    juce::HeapBlock<int> framesToSkip;
+    int numChannels = 0;
+    int maxBlockSize = 1;
+    int factorIndex = 1;
+
+    juce::dsp::Oversampling<float>& getOversampler (int channel) const noexcept
+    {
+        return *oversamplers.getUnchecked (factorIndex * numChannels + channel);
+    }
+
+    // adds driven to every stride-th float of dest, after any frames still to be skipped
+    void addToLane (int channel, const float* driven, float* dest, int numFrames, int stride) noexcept
+    {
+        int& skip = framesToSkip[channel];
+        const int skipped = juce::jmin (skip, numFrames);
+        skip -= skipped;
+
+        if (stride == 1)
+        {
+            juce::FloatVectorOperations::add (dest + skipped, driven + skipped, numFrames - skipped);
+            return;
+        }
+
+        for (int j = skipped; j < numFrames; ++j)
+            dest[j * stride] += driven[j];
+    }
+
+    void processChannel (int channel, const float* source, float* dest, int numSamples, float drive) noexcept
+    {
+        juce::dsp::Oversampling<float>& oversampler = getOversampler (channel);
+
+        // the whole input is taken in before any output is written
+        const float* sourceChannels[] = { source };
+        float* destChannels[] = { dest };
+        juce::dsp::AudioBlock<float> output (destChannels, 1, (size_t) numSamples);
+        juce::dsp::AudioBlock<float> upsampled = oversampler.processSamplesUp (juce::dsp::AudioBlock<const float> (sourceChannels, 1, (size_t) numSamples));
+        shape (upsampled.getChannelPointer (0), (int) upsampled.getNumSamples(), drive);
+        oversampler.processSamplesDown (output);
+    }
+
+    /*  Straight up to a knee that drive lowers from full scale to -20 dB, then
+        a tanh bend towards full scale. The slope is 1 below the knee and at
+        it, so quiet repeats keep their level and the loop can never grow,
+        and a repeat at full scale still comes back at 0.78 of it or more.
+        drive goes from 0 to 1.
+    */
+    static void shape (float* data, int numSamples, float drive) noexcept
+    {
+        const float range = juce::jmax (0.9f * drive, 1.0e-6f);
+        const float knee = 1.0f - range;
+
+        for (int j = 0; j < numSamples; ++j)
+        {
+            const float x = data[j];
+            const float level = std::abs (x);
+            // the approximation holds up to 5, where tanh is within 1e-4 of 1
+            const float over = juce::jmin (juce::jmax (level - knee, 0.0f) / range, 5.0f);
+            const float y = juce::jmin (level, knee) + range * juce::dsp::FastMathApproximations::tanh (over);
+            data[j] = x < 0.0f ? -y : y;
+        }
+    }
+
+    JUCE_DECLARE_NON_COPYABLE (FeedbackDrive)
+};
@@ -0,0 +1,143 @@
+/*
+  ==============================================================================
+
+    FeedbackFilter.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/*
+    The tone stage in the feedback loop: a one-pole low cut followed by a
+    one-pole high cut, both topology-preserving so they stay well behaved
+    while the cutoffs move.
+
+    process() runs over a whole segment of frames with the coefficients held
+    for the block. The filters are recursive in time, so the inner loop runs
+    across the lanes of a frame, which the compiler vectorises when the delay
+    is stored interleaved. state belongs to one line, one value per lane for
+    each filter.
+*/
+class FeedbackFilter
+{
+public:
+    FeedbackFilter() = default;
+
+    // the ends of the cutoff ranges switch a filter off
+    static constexpr float minLowCutHz = 20.0f;
+    static constexpr float maxHighCutHz = 20000.0f;
+
+    void setCutoffs (double sampleRate, float lowCutHz, float highCutHz) noexcept
+    {
+        lowCutActive = lowCutHz > minLowCutHz;
+        highCutActive = highCutHz < maxHighCutHz;
+        lowCutGain = getGain (sampleRate, lowCutHz);
+        highCutGain = getGain (sampleRate, highCutHz);
+    }
+
+    bool isActive() const noexcept      { return lowCutActive || highCutActive; }
+
+    /*  Filters numFrames frames of numLanes samples from source into dest.
+        lowCutState and highCutState hold numLanes values each.
+    */
+    void process (const float* source, float* dest, int numFrames, int numLanes,
+                  float* lowCutState, float* highCutState) const noexcept
+    {
+        // both filters share one loop, so their recursions overlap
+        if (lowCutActive && highCutActive)
+            processStages<true, true> (source, dest, numFrames, numLanes, lowCutState, highCutState);
+        else if (lowCutActive)
+            processStages<true, false> (source, dest, numFrames, numLanes, lowCutState, highCutState);
+        else if (highCutActive)
+            processStages<false, true> (source, dest, numFrames, numLanes, lowCutState, highCutState);
+        else
+            juce::FloatVectorOperations::copy (dest, source, numFrames * numLanes);
+    }
+
+    /*  Cubic soft clipper, unity gain for small signals. drive goes from 0 to 1
+        and lowers the level where the curve starts to bend, from 1.5 down to
+        0.375, so louder repeats are pushed into it harder. Only whole-vector
+        operations, no per-sample branches.
+    */
+    static void saturate (float* data, float* temp, int numSamples, float drive) noexcept
+    {
+        const float inputGain = 1.0f + 3.0f * drive;
+
+        juce::FloatVectorOperations::multiply (data, inputGain, numSamples);
+        juce::FloatVectorOperations::clip (data, data, -1.5f, 1.5f, numSamples);
+
+        // y = x - x^3 / 6.75, which flattens out at +-1 for x = +-1.5
+        juce::FloatVectorOperations::multiply (temp, data, data, numSamples);
+        juce::FloatVectorOperations::multiply (temp, -1.0f / 6.75f, numSamples);
+        juce::FloatVectorOperations::add (temp, 1.0f, numSamples);
+        juce::FloatVectorOperations::multiply (data, temp, numSamples);
+
+        juce::FloatVectorOperations::multiply (data, 1.0f / inputGain, numSamples);
+    }
+
+private:
+    float lowCutGain = 0.0f, highCutGain = 0.0f;
+    bool lowCutActive = false, highCutActive = false;
+
+    template <bool lowCut, bool highCut>
+    float processSample (float sample, float& lowCutState, float& highCutState) const noexcept
+    {
+        if (lowCut)
+        {
+            // the high-pass output is the input minus the one-pole's low-pass
+            const float v = (sample - lowCutState) * lowCutGain;
+            const float lowPass = v + lowCutState;
+            lowCutState = lowPass + v;
+            sample -= lowPass;
+        }
+
+        if (highCut)
+        {
+            const float v = (sample - highCutState) * highCutGain;
+            const float lowPass = v + highCutState;
+            highCutState = lowPass + v;
+            sample = lowPass;
+        }
+
+        return sample;
+    }
+
+    template <bool lowCut, bool highCut>
+    void processStages (const float* source, float* dest, int numFrames, int numLanes,
+                        float* lowCutState, float* highCutState) const noexcept
+    {
+        if (numLanes == 1)
+        {
+            // a planar line keeps its states in registers for the whole run
+            float low = lowCutState[0], high = highCutState[0];
+
+            for (int j = 0; j < numFrames; ++j)
+                dest[j] = processSample<lowCut, highCut> (source[j], low, high);
+
+            lowCutState[0] = low;
+            highCutState[0] = high;
+            return;
+        }
+
+        for (int j = 0; j < numFrames; ++j)
+        {
+            const float* x = source + j * numLanes;
+            float* y = dest + j * numLanes;
+
+            for (int lane = 0; lane < numLanes; ++lane)
+                y[lane] = processSample<lowCut, highCut> (x[lane], lowCutState[lane], highCutState[lane]);
+        }
+    }
+
+    static float getGain (double sampleRate, float cutoffHz) noexcept
+    {
+        // keep the prewarped cutoff clear of Nyquist
+        const double cutoff = juce::jmin ((double) cutoffHz, 0.45 * sampleRate);
+        const double g = std::tan (juce::MathConstants<double>::pi * cutoff / sampleRate);
+        return (float) (g / (1.0 + g));
+    }
+};
@@ -0,0 +1,163 @@
+/*
+  ==============================================================================
+
+    FeedbackMatrix.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/*
+    Routes the feedback between the channels' delay lines. Every frame of the
+    feedback is multiplied by an N x N matrix, N being the number of channels,
+    before the input is added to it:
+
+    - independent leaves every channel feeding only itself and does nothing.
+    - ping-pong hands each channel's repeats on to the next one, the last one
+      to the first, so a repeat goes round every channel in turn.
+    - cross-feed keeps part of each channel and spreads the rest evenly over
+      the others, from none of it at 0 to all of it at 1.
+    - householder is I - 2/N, which is orthogonal and mixes every channel
+      into every other one, a diffusing reflection for three or more
+      channels. For two it is a ping-pong with the polarity flipped.
+
+    None of them make the loop louder as a whole, the level of the frame is
+    kept or lowered, but a single channel may end up above its input.
+
+    The matrix is stored a column per input channel, so a frame is mixed as
+    N multiply-adds of a whole column, which the compiler vectorises.
+*/
+class FeedbackMatrix
+{
+public:
+    FeedbackMatrix() = default;
+
+    enum Modes
+    {
+        independent = 0,
+        pingPong,
+        crossFeed,
+        householder
+    };
+
+    static constexpr int maxSize = 16;
+
+    static juce::StringArray getNames()
+    {
+        return { "Independent", "Ping-pong", "Cross-feed", "Householder" };
+    }
+
+    void setMatrix (int newMode, int newSize, float crossFeedAmount) noexcept
+    {
+        mode = newMode;
+        size = juce::jlimit (1, maxSize, newSize);
+        active = mode != independent && size > 1;
+
+        const float n = (float) size;
+        for (int column = 0; column < size; ++column)
+        {
+            for (int row = 0; row < size; ++row)
+            {
+                float gain = row == column ? 1.0f : 0.0f;
+
+                if (mode == pingPong)
+                    gain = row == (column + 1) % size ? 1.0f : 0.0f;
+                else if (mode == crossFeed)
+                    gain = row == column ? 1.0f - crossFeedAmount : crossFeedAmount / (n - 1.0f);
+                else if (mode == householder)
+                    gain -= 2.0f / n;
+
+                coefficients[column * size + row] = gain;
+            }
+        }
+    }
+
+    bool isActive() const noexcept      { return active; }
+
+    /*  How far above the loudest channel going in a single channel can get,
+        however many times round the loop. The level of a frame never grows,
+        so at worst one channel ends up with all of it.
+    */
+    static double getPeakGain (int mode, int size) noexcept
+    {
+        return mode != independent && size > 1 ? std::sqrt ((double) size) : 1.0;
+    }
+
+    // a ping-pong starts from one channel, the loop takes the input as a mono sum into the first
+    bool takesMonoInput() const noexcept    { return active && mode == pingPong; }
+
+    // Mixes numFrames frames of size lanes each, in place.
+    void process (float* frames, int numFrames) const noexcept
+    {
+        // stereo and quad get loops of their own, unrolled with the matrix held in registers
+        if (size == 2)
+            processFrames<2> (frames, numFrames);
+        else if (size == 4)
+            processFrames<4> (frames, numFrames);
+        else
+            processFrames<0> (frames, numFrames);
+    }
+
+    // Mixes numFrames frames of size separate lines, in place.
+    void processLines (float* const* lines, int numFrames) const noexcept
+    {
+        // the frames are gathered into a block of interleaved ones first
+        constexpr int blockFrames = 64;
+        float block[blockFrames * maxSize];
+
+        for (int done = 0; done < numFrames;)
+        {
+            const int n = juce::jmin (blockFrames, numFrames - done);
+
+            for (int line = 0; line < size; ++line)
+                for (int j = 0; j < n; ++j)
+                    block[j * size + line] = lines[line][done + j];
+
+            process (block, n);
+
+            for (int line = 0; line < size; ++line)
+                for (int j = 0; j < n; ++j)
+                    lines[line][done + j] = block[j * size + line];
+
+            done += n;
+        }
+    }
+
+private:
+    float coefficients[maxSize * maxSize] = {};
+    int mode = independent;
+    int size = 1;
+    bool active = false;
+
+    // fixedSize is the number of channels, or 0 to take it from size
+    template <int fixedSize>
+    void processFrames (float* frames, int numFrames) const noexcept
+    {
+        const int n = fixedSize > 0 ? fixedSize : size;
+        float mixed[maxSize];
+
+        for (int j = 0; j < numFrames; ++j)
+        {
+            float* frame = frames + j * n;
+
+            for (int row = 0; row < n; ++row)
+                mixed[row] = 0.0f;
+
+            for (int column = 0; column < n; ++column)
+            {
+                const float input = frame[column];
+                const float* gains = coefficients + column * n;
+
+                for (int row = 0; row < n; ++row)
+                    mixed[row] += gains[row] * input;
+            }
+
+            for (int row = 0; row < n; ++row)
+                frame[row] = mixed[row];
+        }
+    }
+};
@@ -0,0 +1,113 @@
+/*
+  ==============================================================================
+
+    MeterQueue.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/*
+    Levels measured on the audio thread and handed to the editor. Every block
+    the audio thread pushes one MeterFrame, the editor pops whatever has
+    arrived on its timer. The queue is a fixed ring behind an AbstractFifo, so
+    neither side locks or allocates. With no editor draining it, frames are
+    dropped once it is full.
+*/
+struct MeterLevel
+{
+    float peak = 0.0f;
+    float rms = 0.0f;
+};
+
+struct MeterFrame
+{
+    MeterLevel input;   // the block coming in, before the dry gain
+    MeterLevel wet;     // the delayed signal and taps, before the wet gain
+    MeterLevel loop;    // what is written back into the delay line
+};
+
+// sums runs of samples into a peak and an RMS, reset for every block
+struct MeterAccumulator
+{
+    float peak = 0.0f;
+    double sumOfSquares = 0.0;
+    juce::int64 numSamples = 0;
+
+    void reset() noexcept
+    {
+        peak = 0.0f;
+        sumOfSquares = 0.0;
+        numSamples = 0;
+    }
+
+    void add (const float* data, int num) noexcept
+    {
+        float runPeak = peak, runSquares = 0.0f;
+
+        for (int i = 0; i < num; ++i)
+        {
+            runPeak = juce::jmax (runPeak, std::abs (data[i]));
+            runSquares += data[i] * data[i];
+        }
+
+        peak = runPeak;
+        sumOfSquares += runSquares;
+        numSamples += num;
+    }
+
+    MeterLevel getLevel() const noexcept
+    {
+        MeterLevel level;
+        level.peak = peak;
+        level.rms = numSamples > 0 ? (float) std::sqrt (sumOfSquares / (double) numSamples) : 0.0f;
+        return level;
+    }
+};
+
+class MeterQueue
+{
+public:
+    MeterQueue() = default;
+
+    // audio thread only, false when the editor has fallen behind
+    bool push (const MeterFrame& frame) noexcept
+    {
+        int start1, size1, start2, size2;
+        fifo.prepareToWrite (1, start1, size1, start2, size2);
+
+        if (size1 + size2 == 0)
+            return false;
+
+        frames[size1 > 0 ? start1 : start2] = frame;
+        fifo.finishedWrite (1);
+        return true;
+    }
+
+    // editor only
+    bool pop (MeterFrame& frame) noexcept
+    {
+        int start1, size1, start2, size2;
+        fifo.prepareToRead (1, start1, size1, start2, size2);
+
+        if (size1 + size2 == 0)
+            return false;
+
+        frame = frames[size1 > 0 ? start1 : start2];
+        fifo.finishedRead (1);
+        return true;
+    }
+
+private:
+    // over a second of 64 sample blocks, far longer than the editor leaves between timer calls
+    static constexpr int capacity = 1024;
+
+    juce::AbstractFifo fifo { capacity };
+    MeterFrame frames[capacity];
+
+    JUCE_DECLARE_NON_COPYABLE (MeterQueue)
+};
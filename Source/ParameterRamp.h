@@ -0,0 +1,126 @@
+/*
+  ==============================================================================
+
+    ParameterRamp.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/*
+    Follows a parameter value on the audio thread, turning each change into a
+    per-sample ramp that is rendered once per block.
+
+    A linear ramp suits values like pan. A multiplicative one moves a gain by
+    the same ratio every sample, so it sweeps evenly in dB instead of spending
+    most of a fade to silence in the last few dB. Zero is taken as -80 dB
+    there, where the ramp starts from or stops before landing on it.
+*/
+class ParameterRamp
+{
+public:
+    ParameterRamp() = default;
+
+    enum Shape
+    {
+        linear,
+        multiplicative
+    };
+
+    void reset (double sampleRate, double rampLengthSeconds, float initialValue, Shape newShape = linear) noexcept
+    {
+        rampLength = juce::jmax (1, (int) (sampleRate * rampLengthSeconds));
+        shape = newShape;
+        target = current = initialValue;
+        countdown = 0;
+    }
+
+    void setTargetValue (float newValue) noexcept
+    {
+        if (newValue != target)
+        {
+            target = newValue;
+            countdown = rampLength;
+
+            if (shape == multiplicative)
+            {
+                jassert (target >= 0.0f);
+                current = juce::jmax (current, silentGain);
+                step = std::pow (juce::jmax (target, silentGain) / current, 1.0f / (float) rampLength);
+            }
+            else
+            {
+                step = (target - current) / (float) rampLength;
+            }
+        }
+    }
+
+    float getTargetValue() const noexcept           { return target; }
+    float getCurrentValue() const noexcept          { return current; }
+
+    /*  Writes the next numSamples values into dest. When the value is steady this
+        returns false without touching dest, and getCurrentValue() can be used as
+        a constant instead.
+    */
+    bool render (float* dest, int numSamples) noexcept
+    {
+        if (countdown == 0)
+            return false;
+
+        const int numRamping = juce::jmin (numSamples, countdown);
+        const float start = current;
+
+        if (shape == multiplicative)
+        {
+            float value = start;
+            for (int i = 0; i < numRamping; ++i)
+                dest[i] = value *= step;
+
+            current = value;
+        }
+        else
+        {
+            for (int i = 0; i < numRamping; ++i)
+                dest[i] = start + step * (float) (i + 1);
+
+            current = start + step * (float) numRamping;
+        }
+
+        countdown -= numRamping;
+        if (countdown == 0)
+            current = target;
+        juce::FloatVectorOperations::fill (dest + numRamping, current, numSamples - numRamping);
+        return true;
+    }
+
+    // moves on numSamples values, as render() would, without writing them anywhere
+    void skip (int numSamples) noexcept
+    {
+        if (countdown == 0)
+            return;
+
+        const int numRamping = juce::jmin (numSamples, countdown);
+        countdown -= numRamping;
+
+        if (countdown == 0)
+            current = target;
+        else if (shape == multiplicative)
+            current *= std::pow (step, (float) numRamping);
+        else
+            current += step * (float) numRamping;
+    }
+
+private:
+    // -80 dB, where a multiplicative ramp meets silence
+    static constexpr float silentGain = 1.0e-4f;
+
+    Shape shape = linear;
+    float target = 0.0f, current = 0.0f, step = 0.0f;
+    int rampLength = 1, countdown = 0;
+
+    JUCE_DECLARE_NON_COPYABLE (ParameterRamp)
+};
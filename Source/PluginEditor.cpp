@@ -19,36 +19,151 @@ DynamicDelayAudioProcessorEditor::DynamicDelayAudioProcessorEditor(DynamicDelayA
      feedbackLabel("", "Feedback:"),
      dryMixLabel("", "Dry:"),
      wetMixLabel("", "Wet:"),
-     crossLengthLabel("", "cross (sec):")
+     crossLengthLabel("", "cross (sec):"),
+     maxDelayLabel("", "Max delay (sec):"),
+     interpolationLabel("", "Interpolation:"),
+     delayModeLabel("", "Mode:"),
+     syncButton("Tempo sync"),
+     divisionLabel("", "Division:"),
+     lowCutLabel("", "Feedback low cut (Hz):"),
+     highCutLabel("", "Feedback high cut (Hz):"),
+     saturationLabel("", "Saturation:"),
+     driveLabel("", "Drive:"),
+     oversamplingLabel("", "Drive oversampling:"),
+     feedbackMatrixLabel("", "Feedback matrix:"),
+     crossFeedLabel("", "Cross-feed:"),
+     reverbLabel("", "Reverb:"),
+     reverbSizeLabel("", "Reverb size:"),
+     reverbDecayLabel("", "Reverb decay (sec):"),
+     reverbLevelLabel("", "Reverb level:"),
+     duckAmountLabel("", "Duck:"),
+     duckAttackLabel("", "Duck attack (sec):"),
+     duckReleaseLabel("", "Duck release (sec):"),
+     duckSidechainButton("Duck on sidechain"),
+     lfoShapeLabel("", "LFO:"),
+     lfoRateLabel("", "LFO rate (Hz):"),
+     lfoDepthLabel("", "LFO depth (ms):"),
+     lfoPhaseLabel("", "LFO phase (deg):"),
+     freezeButton("Freeze"),
+     rightOffsetLabel("", "Right offset (ms):"),
+     numTapsLabel("", "Taps:"),
+     tapLabel("", "Edit tap:"),
+     tapTimeLabel("", "Tap time (sec):"),
+     tapGainLabel("", "Tap gain:"),
+     tapPanLabel("", "Tap pan:"),
+     delayBufferView(p.delaySummary)
 {
     // In your constructor, you should add any child components, and
     // initialise any special settings that your component needs.
-    setSize (690, 471);
+    setSize (690, 851);
     
     delayLengthSlider.setSliderStyle(juce::Slider::LinearHorizontal);
-    delayLengthSlider.addListener(this);
-    delayLengthSlider.setRange(0.01, 2.0, 0.01);
     addAndMakeVisible(&delayLengthSlider);
     
     feedbackSlider.setSliderStyle(juce::Slider::Rotary);
-    feedbackSlider.addListener(this);
-    feedbackSlider.setRange(0.0, 0.995, 0.005);
     addAndMakeVisible(&feedbackSlider);
     
     dryMixSlider.setSliderStyle(juce::Slider::Rotary);
-    dryMixSlider.addListener(this);
-    dryMixSlider.setRange(0.0, 1.0, 0.01);
     addAndMakeVisible(&dryMixSlider);
 
     wetMixSlider.setSliderStyle(juce::Slider::Rotary);
-    wetMixSlider.addListener(this);
-    wetMixSlider.setRange(0.0, 1.0, 0.01);
     addAndMakeVisible(&wetMixSlider);
 
     crossLengthSlider.setSliderStyle(juce::Slider::Rotary);
-    crossLengthSlider.addListener(this);
-    crossLengthSlider.setRange(0.0, 2.0, 0.01);
     addAndMakeVisible(&crossLengthSlider);
+
+    maxDelaySlider.setSliderStyle(juce::Slider::Rotary);
+    addAndMakeVisible(&maxDelaySlider);
+
+    // item IDs start at 1, the attachment maps them onto the choice index
+    interpolationBox.addItemList(DelayInterpolation::getNames(), 1);
+    addAndMakeVisible(&interpolationBox);
+
+    delayModeBox.addItemList(DynamicDelayAudioProcessor::getDelayModeNames(), 1);
+    addAndMakeVisible(&delayModeBox);
+
+    addAndMakeVisible(&syncButton);
+
+    divisionBox.addItemList(DynamicDelayAudioProcessor::getDivisionNames(), 1);
+    addAndMakeVisible(&divisionBox);
+
+    lowCutSlider.setSliderStyle(juce::Slider::Rotary);
+    addAndMakeVisible(&lowCutSlider);
+
+    highCutSlider.setSliderStyle(juce::Slider::Rotary);
+    addAndMakeVisible(&highCutSlider);
+
+    saturationSlider.setSliderStyle(juce::Slider::Rotary);
+    addAndMakeVisible(&saturationSlider);
+
+    driveSlider.setSliderStyle(juce::Slider::Rotary);
+    addAndMakeVisible(&driveSlider);
+
+    oversamplingBox.addItemList(FeedbackDrive::getOversamplingNames(), 1);
+    addAndMakeVisible(&oversamplingBox);
+
+    feedbackMatrixBox.addItemList(FeedbackMatrix::getNames(), 1);
+    addAndMakeVisible(&feedbackMatrixBox);
+
+    crossFeedSlider.setSliderStyle(juce::Slider::Rotary);
+    addAndMakeVisible(&crossFeedSlider);
+
+    reverbBox.addItemList(FdnReverb::getNames(), 1);
+    addAndMakeVisible(&reverbBox);
+
+    reverbSizeSlider.setSliderStyle(juce::Slider::Rotary);
+    addAndMakeVisible(&reverbSizeSlider);
+
+    reverbDecaySlider.setSliderStyle(juce::Slider::Rotary);
+    addAndMakeVisible(&reverbDecaySlider);
+
+    reverbLevelSlider.setSliderStyle(juce::Slider::Rotary);
+    addAndMakeVisible(&reverbLevelSlider);
+
+    duckAmountSlider.setSliderStyle(juce::Slider::Rotary);
+    addAndMakeVisible(&duckAmountSlider);
+
+    duckAttackSlider.setSliderStyle(juce::Slider::Rotary);
+    addAndMakeVisible(&duckAttackSlider);
+
+    duckReleaseSlider.setSliderStyle(juce::Slider::Rotary);
+    addAndMakeVisible(&duckReleaseSlider);
+
+    addAndMakeVisible(&duckSidechainButton);
+
+    lfoShapeBox.addItemList(DelayLfo::getNames(), 1);
+    addAndMakeVisible(&lfoShapeBox);
+
+    lfoRateSlider.setSliderStyle(juce::Slider::Rotary);
+    addAndMakeVisible(&lfoRateSlider);
+
+    lfoDepthSlider.setSliderStyle(juce::Slider::Rotary);
+    addAndMakeVisible(&lfoDepthSlider);
+
+    lfoPhaseSlider.setSliderStyle(juce::Slider::Rotary);
+    addAndMakeVisible(&lfoPhaseSlider);
+
+    addAndMakeVisible(&freezeButton);
+
+    rightOffsetSlider.setSliderStyle(juce::Slider::LinearHorizontal);
+    addAndMakeVisible(&rightOffsetSlider);
+
+    numTapsSlider.setSliderStyle(juce::Slider::Rotary);
+    addAndMakeVisible(&numTapsSlider);
+
+    for (int t = 0; t < DynamicDelayAudioProcessor::maxNumTaps; ++t)
+        tapBox.addItem("tap " + juce::String(t + 1), t + 1);
+    tapBox.onChange = [this] { selectTap(tapBox.getSelectedItemIndex()); };
+    addAndMakeVisible(&tapBox);
+
+    tapTimeSlider.setSliderStyle(juce::Slider::LinearHorizontal);
+    addAndMakeVisible(&tapTimeSlider);
+
+    tapGainSlider.setSliderStyle(juce::Slider::Rotary);
+    addAndMakeVisible(&tapGainSlider);
+
+    tapPanSlider.setSliderStyle(juce::Slider::Rotary);
+    addAndMakeVisible(&tapPanSlider);
     
     delayLengthLabel.attachToComponent(&delayLengthSlider, false);
     delayLengthLabel.setFont(juce::Font (11.0f));
@@ -65,38 +180,225 @@ DynamicDelayAudioProcessorEditor::DynamicDelayAudioProcessorEditor(DynamicDelayA
     crossLengthLabel.attachToComponent(&crossLengthSlider, false);
     crossLengthLabel.setFont(juce::Font (11.0f));
 
-    startTimer(50);
+    maxDelayLabel.attachToComponent(&maxDelaySlider, false);
+    maxDelayLabel.setFont(juce::Font (11.0f));
+
+    interpolationLabel.attachToComponent(&interpolationBox, false);
+    interpolationLabel.setFont(juce::Font (11.0f));
+
+    delayModeLabel.attachToComponent(&delayModeBox, false);
+    delayModeLabel.setFont(juce::Font (11.0f));
+
+    divisionLabel.attachToComponent(&divisionBox, false);
+    divisionLabel.setFont(juce::Font (11.0f));
+
+    lowCutLabel.attachToComponent(&lowCutSlider, false);
+    lowCutLabel.setFont(juce::Font (11.0f));
+
+    highCutLabel.attachToComponent(&highCutSlider, false);
+    highCutLabel.setFont(juce::Font (11.0f));
+
+    saturationLabel.attachToComponent(&saturationSlider, false);
+    saturationLabel.setFont(juce::Font (11.0f));
+
+    driveLabel.attachToComponent(&driveSlider, false);
+    driveLabel.setFont(juce::Font (11.0f));
+
+    oversamplingLabel.attachToComponent(&oversamplingBox, false);
+    oversamplingLabel.setFont(juce::Font (11.0f));
+
+    feedbackMatrixLabel.attachToComponent(&feedbackMatrixBox, false);
+    feedbackMatrixLabel.setFont(juce::Font (11.0f));
+
+    crossFeedLabel.attachToComponent(&crossFeedSlider, false);
+    crossFeedLabel.setFont(juce::Font (11.0f));
+
+    reverbLabel.attachToComponent(&reverbBox, false);
+    reverbLabel.setFont(juce::Font (11.0f));
 
+    reverbSizeLabel.attachToComponent(&reverbSizeSlider, false);
+    reverbSizeLabel.setFont(juce::Font (11.0f));
+
+    reverbDecayLabel.attachToComponent(&reverbDecaySlider, false);
+    reverbDecayLabel.setFont(juce::Font (11.0f));
+
+    reverbLevelLabel.attachToComponent(&reverbLevelSlider, false);
+    reverbLevelLabel.setFont(juce::Font (11.0f));
+
+    duckAmountLabel.attachToComponent(&duckAmountSlider, false);
+    duckAmountLabel.setFont(juce::Font (11.0f));
+
+    duckAttackLabel.attachToComponent(&duckAttackSlider, false);
+    duckAttackLabel.setFont(juce::Font (11.0f));
+
+    duckReleaseLabel.attachToComponent(&duckReleaseSlider, false);
+    duckReleaseLabel.setFont(juce::Font (11.0f));
+
+    lfoShapeLabel.attachToComponent(&lfoShapeBox, false);
+    lfoShapeLabel.setFont(juce::Font (11.0f));
+
+    lfoRateLabel.attachToComponent(&lfoRateSlider, false);
+    lfoRateLabel.setFont(juce::Font (11.0f));
+
+    lfoDepthLabel.attachToComponent(&lfoDepthSlider, false);
+    lfoDepthLabel.setFont(juce::Font (11.0f));
+
+    lfoPhaseLabel.attachToComponent(&lfoPhaseSlider, false);
+    lfoPhaseLabel.setFont(juce::Font (11.0f));
+
+    rightOffsetLabel.attachToComponent(&rightOffsetSlider, false);
+    rightOffsetLabel.setFont(juce::Font (11.0f));
+
+    numTapsLabel.attachToComponent(&numTapsSlider, false);
+    numTapsLabel.setFont(juce::Font (11.0f));
+
+    tapLabel.attachToComponent(&tapBox, false);
+    tapLabel.setFont(juce::Font (11.0f));
+
+    tapTimeLabel.attachToComponent(&tapTimeSlider, false);
+    tapTimeLabel.setFont(juce::Font (11.0f));
+
+    tapGainLabel.attachToComponent(&tapGainSlider, false);
+    tapGainLabel.setFont(juce::Font (11.0f));
+
+    tapPanLabel.attachToComponent(&tapPanSlider, false);
+    tapPanLabel.setFont(juce::Font (11.0f));
+
+    // the attachments keep the sliders and the parameters in sync in both directions
+    juce::AudioProcessorValueTreeState& parameters = processor.parameters;
+    delayLengthAttachment.reset(new SliderAttachment(parameters, DynamicDelayAudioProcessor::getParameterID(DynamicDelayAudioProcessor::delayLengthParam), delayLengthSlider));
+    feedbackAttachment.reset(new SliderAttachment(parameters, DynamicDelayAudioProcessor::getParameterID(DynamicDelayAudioProcessor::feedbackParam), feedbackSlider));
+    dryMixAttachment.reset(new SliderAttachment(parameters, DynamicDelayAudioProcessor::getParameterID(DynamicDelayAudioProcessor::dryMixParam), dryMixSlider));
+    wetMixAttachment.reset(new SliderAttachment(parameters, DynamicDelayAudioProcessor::getParameterID(DynamicDelayAudioProcessor::wetMixParam), wetMixSlider));
+    crossLengthAttachment.reset(new SliderAttachment(parameters, DynamicDelayAudioProcessor::getParameterID(DynamicDelayAudioProcessor::crossLengthParam), crossLengthSlider));
+    maxDelayAttachment.reset(new SliderAttachment(parameters, DynamicDelayAudioProcessor::getParameterID(DynamicDelayAudioProcessor::maxDelayParam), maxDelaySlider));
+    interpolationAttachment.reset(new ComboBoxAttachment(parameters, DynamicDelayAudioProcessor::getParameterID(DynamicDelayAudioProcessor::interpolationParam), interpolationBox));
+    delayModeAttachment.reset(new ComboBoxAttachment(parameters, DynamicDelayAudioProcessor::getParameterID(DynamicDelayAudioProcessor::delayModeParam), delayModeBox));
+    syncAttachment.reset(new ButtonAttachment(parameters, DynamicDelayAudioProcessor::getParameterID(DynamicDelayAudioProcessor::syncParam), syncButton));
+    divisionAttachment.reset(new ComboBoxAttachment(parameters, DynamicDelayAudioProcessor::getParameterID(DynamicDelayAudioProcessor::divisionParam), divisionBox));
+    lowCutAttachment.reset(new SliderAttachment(parameters, DynamicDelayAudioProcessor::getParameterID(DynamicDelayAudioProcessor::lowCutParam), lowCutSlider));
+    highCutAttachment.reset(new SliderAttachment(parameters, DynamicDelayAudioProcessor::getParameterID(DynamicDelayAudioProcessor::highCutParam), highCutSlider));
+    saturationAttachment.reset(new SliderAttachment(parameters, DynamicDelayAudioProcessor::getParameterID(DynamicDelayAudioProcessor::saturationParam), saturationSlider));
+    driveAttachment.reset(new SliderAttachment(parameters, DynamicDelayAudioProcessor::getParameterID(DynamicDelayAudioProcessor::driveParam), driveSlider));
+    oversamplingAttachment.reset(new ComboBoxAttachment(parameters, DynamicDelayAudioProcessor::getParameterID(DynamicDelayAudioProcessor::oversamplingParam), oversamplingBox));
+    feedbackMatrixAttachment.reset(new ComboBoxAttachment(parameters, DynamicDelayAudioProcessor::getParameterID(DynamicDelayAudioProcessor::feedbackMatrixParam), feedbackMatrixBox));
+    crossFeedAttachment.reset(new SliderAttachment(parameters, DynamicDelayAudioProcessor::getParameterID(DynamicDelayAudioProcessor::crossFeedParam), crossFeedSlider));
+    reverbAttachment.reset(new ComboBoxAttachment(parameters, DynamicDelayAudioProcessor::getParameterID(DynamicDelayAudioProcessor::reverbParam), reverbBox));
+    reverbSizeAttachment.reset(new SliderAttachment(parameters, DynamicDelayAudioProcessor::getParameterID(DynamicDelayAudioProcessor::reverbSizeParam), reverbSizeSlider));
+    reverbDecayAttachment.reset(new SliderAttachment(parameters, DynamicDelayAudioProcessor::getParameterID(DynamicDelayAudioProcessor::reverbDecayParam), reverbDecaySlider));
+    reverbLevelAttachment.reset(new SliderAttachment(parameters, DynamicDelayAudioProcessor::getParameterID(DynamicDelayAudioProcessor::reverbLevelParam), reverbLevelSlider));
+    duckAmountAttachment.reset(new SliderAttachment(parameters, DynamicDelayAudioProcessor::getParameterID(DynamicDelayAudioProcessor::duckAmountParam), duckAmountSlider));
+    duckAttackAttachment.reset(new SliderAttachment(parameters, DynamicDelayAudioProcessor::getParameterID(DynamicDelayAudioProcessor::duckAttackParam), duckAttackSlider));
+    duckReleaseAttachment.reset(new SliderAttachment(parameters, DynamicDelayAudioProcessor::getParameterID(DynamicDelayAudioProcessor::duckReleaseParam), duckReleaseSlider));
+    duckSidechainAttachment.reset(new ButtonAttachment(parameters, DynamicDelayAudioProcessor::getParameterID(DynamicDelayAudioProcessor::duckSidechainParam), duckSidechainButton));
+    lfoShapeAttachment.reset(new ComboBoxAttachment(parameters, DynamicDelayAudioProcessor::getParameterID(DynamicDelayAudioProcessor::lfoShapeParam), lfoShapeBox));
+    lfoRateAttachment.reset(new SliderAttachment(parameters, DynamicDelayAudioProcessor::getParameterID(DynamicDelayAudioProcessor::lfoRateParam), lfoRateSlider));
+    lfoDepthAttachment.reset(new SliderAttachment(parameters, DynamicDelayAudioProcessor::getParameterID(DynamicDelayAudioProcessor::lfoDepthParam), lfoDepthSlider));
+    lfoPhaseAttachment.reset(new SliderAttachment(parameters, DynamicDelayAudioProcessor::getParameterID(DynamicDelayAudioProcessor::lfoPhaseParam), lfoPhaseSlider));
+    freezeAttachment.reset(new ButtonAttachment(parameters, DynamicDelayAudioProcessor::getParameterID(DynamicDelayAudioProcessor::freezeParam), freezeButton));
+    rightOffsetAttachment.reset(new SliderAttachment(parameters, DynamicDelayAudioProcessor::getParameterID(DynamicDelayAudioProcessor::rightOffsetParam), rightOffsetSlider));
+    numTapsAttachment.reset(new SliderAttachment(parameters, DynamicDelayAudioProcessor::getParameterID(DynamicDelayAudioProcessor::numTapsParam), numTapsSlider));
+
+    tapBox.setSelectedItemIndex(0, juce::dontSendNotification);
+    selectTap(0);
+
+    // whatever piled up while no editor was open is stale
+    MeterFrame frame;
+    while (processor.meterQueue.pop(frame))
+        ;
+    addAndMakeVisible(&delayBufferView);
+    startTimerHz(30);
 }
 
 DynamicDelayAudioProcessorEditor::~DynamicDelayAudioProcessorEditor()
 {
+    stopTimer();
 }
 
-void DynamicDelayAudioProcessorEditor::timerCallback()
+void DynamicDelayAudioProcessorEditor::selectTap (int tap)
 {
-    DynamicDelayAudioProcessor* ourProcessor = getProcessor();
-    
-    delayLengthSlider.setValue(ourProcessor->delayLength, juce::dontSendNotification);
-    feedbackSlider.setValue(ourProcessor->feedback, juce::dontSendNotification);
-    dryMixSlider.setValue(ourProcessor->dryMix, juce::dontSendNotification);
-    wetMixSlider.setValue(ourProcessor->wetMix, juce::dontSendNotification);
-    crossLengthSlider.setValue(ourProcessor->crossLength, juce::dontSendNotification);
+    if (tap < 0)
+        return;
+
+    // the old attachments go first so only one of them drives each slider
+    tapTimeAttachment.reset();
+    tapGainAttachment.reset();
+    tapPanAttachment.reset();
+
+    juce::AudioProcessorValueTreeState& parameters = processor.parameters;
+    tapTimeAttachment.reset(new SliderAttachment(parameters, DynamicDelayAudioProcessor::getParameterID(DynamicDelayAudioProcessor::getTapParameterIndex(tap, DynamicDelayAudioProcessor::tapTimeParam)), tapTimeSlider));
+    tapGainAttachment.reset(new SliderAttachment(parameters, DynamicDelayAudioProcessor::getParameterID(DynamicDelayAudioProcessor::getTapParameterIndex(tap, DynamicDelayAudioProcessor::tapGainParam)), tapGainSlider));
+    tapPanAttachment.reset(new SliderAttachment(parameters, DynamicDelayAudioProcessor::getParameterID(DynamicDelayAudioProcessor::getTapParameterIndex(tap, DynamicDelayAudioProcessor::tapPanParam)), tapPanSlider));
+}
+
+// per timer call at 30 Hz, about 20 dB a second
+static const float meterFallback = 0.85f;
+
+// falls back once per call whatever the block size, then jumps up to a louder level
+static void updateMeter (float& display, float level)
+{
+    display = juce::jmax(display * meterFallback, level);
 }
 
-void DynamicDelayAudioProcessorEditor::sliderValueChanged(juce::Slider* slider)
+static void takeLoudest (MeterLevel& loudest, const MeterLevel& level)
 {
-    if (slider == &delayLengthSlider) {
-        getProcessor()->setParameterNotifyingHost(DynamicDelayAudioProcessor::delayLengthParam, (float) delayLengthSlider.getValue());
-    } else if (slider == &feedbackSlider) {
-        getProcessor()->setParameterNotifyingHost(DynamicDelayAudioProcessor::feedbackParam, (float) feedbackSlider.getValue());
-    } else if (slider == &dryMixSlider) {
-        getProcessor()->setParameterNotifyingHost(DynamicDelayAudioProcessor::dryMixParam, (float) dryMixSlider.getValue());
-    } else if (slider == &wetMixSlider) {
-        getProcessor()->setParameterNotifyingHost(DynamicDelayAudioProcessor::wetMixParam, (float) wetMixSlider.getValue());
-    } else if (slider == &crossLengthSlider) {
-        getProcessor()->setParameterNotifyingHost(DynamicDelayAudioProcessor::crossLengthParam, (float) crossLengthSlider.getValue());
+    loudest.peak = juce::jmax(loudest.peak, level.peak);
+    loudest.rms = juce::jmax(loudest.rms, level.rms);
+}
+
+void DynamicDelayAudioProcessorEditor::timerCallback()
+{
+    // every block since the last call, the loudest of them is shown
+    MeterLevel input, wet, loop;
+    MeterFrame frame;
+    while (processor.meterQueue.pop(frame))
+    {
+        takeLoudest(input, frame.input);
+        takeLoudest(wet, frame.wet);
+        takeLoudest(loop, frame.loop);
     }
+
+    updateMeter(inputMeter.peak, input.peak);
+    updateMeter(inputMeter.rms, input.rms);
+    updateMeter(wetMeter.peak, wet.peak);
+    updateMeter(wetMeter.rms, wet.rms);
+    updateMeter(loopMeter.peak, loop.peak);
+    updateMeter(loopMeter.rms, loop.rms);
+
+    repaint(meterArea);
+    delayBufferView.update();
+}
+
+void DynamicDelayAudioProcessorEditor::paintMeter (juce::Graphics& g, juce::Rectangle<int> bounds, const juce::String& name,
+                                                   const MeterDisplay& meter, bool warnAboveFullScale) const
+{
+    // -60 to +6 dB from the bottom of the bar to the top
+    const auto toHeight = [&bounds] (float level)
+    {
+        const float db = juce::Decibels::gainToDecibels(level, -60.0f);
+        return juce::roundToInt((db + 60.0f) / 66.0f * (float) bounds.getHeight());
+    };
+
+    g.setColour(juce::Colours::white);
+    g.setFont(11.0f);
+    g.drawText(name, bounds.removeFromBottom(16), juce::Justification::centred);
+
+    g.setColour(juce::Colours::darkgrey);
+    g.fillRect(bounds);
+
+    // a loop running over full scale is building up, and shown in red
+    const bool over = warnAboveFullScale && meter.peak > 1.0f;
+    const int rmsHeight = toHeight(meter.rms);
+    g.setColour(over ? juce::Colours::red : juce::Colours::limegreen);
+    g.fillRect(bounds.getX(), bounds.getBottom() - rmsHeight, bounds.getWidth(), rmsHeight);
+
+    const int peakHeight = toHeight(meter.peak);
+    g.setColour(over ? juce::Colours::orange : juce::Colours::white);
+    g.fillRect(bounds.getX(), bounds.getBottom() - peakHeight, bounds.getWidth(), 2);
+
+    const int fullScale = toHeight(1.0f);
+    g.setColour(juce::Colours::grey);
+    g.fillRect(bounds.getX(), bounds.getBottom() - fullScale, bounds.getWidth(), 1);
 }
 
 void DynamicDelayAudioProcessorEditor::paint (juce::Graphics& g)
@@ -109,6 +411,13 @@ void DynamicDelayAudioProcessorEditor::paint (juce::Graphics& g)
     g.setColour (juce::Colours::black);
     g.setFont (15.0f);
     g.drawFittedText ("This is Dynamic Delay", getLocalBounds(), juce::Justification::centred, 1);
+
+    // input, wet and loop levels side by side
+    juce::Rectangle<int> area = meterArea;
+    const int meterWidth = area.getWidth() / 3;
+    paintMeter(g, area.removeFromLeft(meterWidth).reduced(4, 0), "In", inputMeter, false);
+    paintMeter(g, area.removeFromLeft(meterWidth).reduced(4, 0), "Wet", wetMeter, false);
+    paintMeter(g, area.reduced(4, 0), "Loop", loopMeter, true);
 }
 
 void DynamicDelayAudioProcessorEditor::resized()
@@ -120,4 +429,37 @@ void DynamicDelayAudioProcessorEditor::resized()
     dryMixSlider.setBounds(20, 80, 150, 40);
     wetMixSlider.setBounds(200, 80, 150, 40);
     crossLengthSlider.setBounds(20, 140, 150, 40);
+    maxDelaySlider.setBounds(380, 20, 150, 40);
+    interpolationBox.setBounds(200, 150, 150, 24);
+    delayModeBox.setBounds(380, 150, 150, 24);
+    numTapsSlider.setBounds(380, 80, 150, 40);
+    syncButton.setBounds(560, 20, 110, 24);
+    divisionBox.setBounds(560, 80, 110, 24);
+    lowCutSlider.setBounds(20, 330, 150, 40);
+    highCutSlider.setBounds(200, 330, 150, 40);
+    saturationSlider.setBounds(380, 330, 150, 40);
+    driveSlider.setBounds(20, 400, 150, 40);
+    oversamplingBox.setBounds(200, 406, 150, 24);
+    feedbackMatrixBox.setBounds(200, 276, 150, 24);
+    crossFeedSlider.setBounds(380, 270, 150, 40);
+    reverbBox.setBounds(380, 406, 150, 24);
+    reverbSizeSlider.setBounds(20, 470, 150, 40);
+    reverbDecaySlider.setBounds(200, 470, 150, 40);
+    reverbLevelSlider.setBounds(380, 470, 150, 40);
+    freezeButton.setBounds(560, 476, 110, 24);
+    duckAmountSlider.setBounds(20, 540, 150, 40);
+    duckAttackSlider.setBounds(200, 540, 150, 40);
+    duckReleaseSlider.setBounds(380, 540, 150, 40);
+    duckSidechainButton.setBounds(560, 546, 110, 24);
+    lfoShapeBox.setBounds(20, 616, 150, 24);
+    lfoRateSlider.setBounds(200, 610, 150, 40);
+    lfoDepthSlider.setBounds(380, 610, 150, 40);
+    lfoPhaseSlider.setBounds(560, 610, 110, 40);
+    tapBox.setBounds(20, 216, 150, 24);
+    tapTimeSlider.setBounds(200, 210, 150, 40);
+    tapGainSlider.setBounds(380, 210, 150, 40);
+    tapPanSlider.setBounds(20, 270, 150, 40);
+    meterArea = juce::Rectangle<int>(560, 140, 110, 300);
+    rightOffsetSlider.setBounds(20, 680, 330, 40);
+    delayBufferView.setBounds(20, 750, 650, 80);
 }
@@ -12,25 +12,96 @@
 
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
+#include "DelayBufferView.h"
 
 //==============================================================================
 /*
 */
-class DynamicDelayAudioProcessorEditor  : public juce::AudioProcessorEditor, public juce::Slider::Listener, public juce::Timer
+class DynamicDelayAudioProcessorEditor  : public juce::AudioProcessorEditor,
+                                          private juce::Timer
 {
 public:
     DynamicDelayAudioProcessorEditor(DynamicDelayAudioProcessor&);
     ~DynamicDelayAudioProcessorEditor() override;
 
-    void timerCallback();
-    void paint (juce::Graphics&);
+    void paint (juce::Graphics&) override;
     void resized() override;
-    void sliderValueChanged (juce::Slider*);
 
 private:
+    using SliderAttachment = juce::AudioProcessorValueTreeState::SliderAttachment;
+    using ComboBoxAttachment = juce::AudioProcessorValueTreeState::ComboBoxAttachment;
+    using ButtonAttachment = juce::AudioProcessorValueTreeState::ButtonAttachment;
+
     DynamicDelayAudioProcessor& processor;
-    juce::Label delayLengthLabel, feedbackLabel, dryMixLabel, wetMixLabel, crossLengthLabel;
-    juce::Slider delayLengthSlider, feedbackSlider, dryMixSlider, wetMixSlider, crossLengthSlider;
+    juce::Label delayLengthLabel, feedbackLabel, dryMixLabel, wetMixLabel, crossLengthLabel, maxDelayLabel;
+    juce::Slider delayLengthSlider, feedbackSlider, dryMixSlider, wetMixSlider, crossLengthSlider, maxDelaySlider;
+    std::unique_ptr<SliderAttachment> delayLengthAttachment, feedbackAttachment, dryMixAttachment, wetMixAttachment, crossLengthAttachment, maxDelayAttachment;
+    juce::Label interpolationLabel, delayModeLabel;
+    juce::ComboBox interpolationBox, delayModeBox;
+    std::unique_ptr<ComboBoxAttachment> interpolationAttachment, delayModeAttachment;
+    juce::ToggleButton syncButton;
+    juce::Label divisionLabel;
+    juce::ComboBox divisionBox;
+    std::unique_ptr<ButtonAttachment> syncAttachment;
+    std::unique_ptr<ComboBoxAttachment> divisionAttachment;
+    juce::Label lowCutLabel, highCutLabel, saturationLabel;
+    juce::Slider lowCutSlider, highCutSlider, saturationSlider;
+    std::unique_ptr<SliderAttachment> lowCutAttachment, highCutAttachment, saturationAttachment;
+    juce::Label driveLabel, oversamplingLabel;
+    juce::Slider driveSlider;
+    juce::ComboBox oversamplingBox;
+    std::unique_ptr<SliderAttachment> driveAttachment;
+    std::unique_ptr<ComboBoxAttachment> oversamplingAttachment;
+    juce::Label feedbackMatrixLabel, crossFeedLabel;
+    juce::ComboBox feedbackMatrixBox;
+    juce::Slider crossFeedSlider;
+    std::unique_ptr<ComboBoxAttachment> feedbackMatrixAttachment;
+    std::unique_ptr<SliderAttachment> crossFeedAttachment;
+    juce::Label reverbLabel, reverbSizeLabel, reverbDecayLabel, reverbLevelLabel;
+    juce::ComboBox reverbBox;
+    juce::Slider reverbSizeSlider, reverbDecaySlider, reverbLevelSlider;
+    std::unique_ptr<ComboBoxAttachment> reverbAttachment;
+    std::unique_ptr<SliderAttachment> reverbSizeAttachment, reverbDecayAttachment, reverbLevelAttachment;
+    juce::Label duckAmountLabel, duckAttackLabel, duckReleaseLabel;
+    juce::Slider duckAmountSlider, duckAttackSlider, duckReleaseSlider;
+    juce::ToggleButton duckSidechainButton;
+    std::unique_ptr<SliderAttachment> duckAmountAttachment, duckAttackAttachment, duckReleaseAttachment;
+    std::unique_ptr<ButtonAttachment> duckSidechainAttachment;
+    juce::Label lfoShapeLabel, lfoRateLabel, lfoDepthLabel, lfoPhaseLabel;
+    juce::ComboBox lfoShapeBox;
+    juce::Slider lfoRateSlider, lfoDepthSlider, lfoPhaseSlider;
+    std::unique_ptr<ComboBoxAttachment> lfoShapeAttachment;
+    std::unique_ptr<SliderAttachment> lfoRateAttachment, lfoDepthAttachment, lfoPhaseAttachment;
+    juce::ToggleButton freezeButton;
+    std::unique_ptr<ButtonAttachment> freezeAttachment;
+    juce::Label rightOffsetLabel;
+    juce::Slider rightOffsetSlider;
+    std::unique_ptr<SliderAttachment> rightOffsetAttachment;
+    
+    // one set of tap controls, attached to whichever tap is picked in tapBox
+    juce::Label numTapsLabel, tapLabel, tapTimeLabel, tapGainLabel, tapPanLabel;
+    juce::Slider numTapsSlider, tapTimeSlider, tapGainSlider, tapPanSlider;
+    juce::ComboBox tapBox;
+    std::unique_ptr<SliderAttachment> numTapsAttachment, tapTimeAttachment, tapGainAttachment, tapPanAttachment;
+    
+    void selectTap (int tap);
+    
+    // The levels drained from the processor's meter queue. Peaks jump up and
+    // fall back slowly, so short hits stay visible between timer calls.
+    struct MeterDisplay
+    {
+        float peak = 0.0f;
+        float rms = 0.0f;
+    };
+    MeterDisplay inputMeter, wetMeter, loopMeter;
+    juce::Rectangle<int> meterArea;
+    
+    // the delay line's contents, redrawn from the processor's summary on the same timer
+    DelayBufferView delayBufferView;
+    
+    void timerCallback() override;
+    void paintMeter (juce::Graphics& g, juce::Rectangle<int> bounds, const juce::String& name,
+                     const MeterDisplay& meter, bool warnAboveFullScale) const;
     
     juce::ScopedPointer<juce::ResizableCornerComponent> resizer;
     juce::ComponentBoundsConstrainer resizeLimits;
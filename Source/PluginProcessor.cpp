@@ -9,31 +9,103 @@
 */
 
 #include "PluginProcessor.h"
-#include "PluginEditor.h"
-#include <vector>
+
+#if ! DYNAMICDELAY_HEADLESS
+ #include "PluginEditor.h"
+#endif
+
+constexpr int DynamicDelayAudioProcessor::maxNumTaps;
 
 //==============================================================================
-DynamicDelayAudioProcessor::DynamicDelayAudioProcessor():delayBuffer(2,1)
+DynamicDelayAudioProcessor::DynamicDelayAudioProcessor()
+    : AudioProcessor(BusesProperties().withInput("Input", juce::AudioChannelSet::stereo(), true)
+                                      .withOutput("Output", juce::AudioChannelSet::stereo(), true)
+                                      .withInput("Sidechain", juce::AudioChannelSet::stereo(), false)),
+      parameters(*this, nullptr, "DynamicDelay", createParameterLayout()),
+      interleavedDelayStore(false),
+      numDelayChannels(2), numDelayLines(2), numDelayLanes(1),
+      delayBuffer(DelayBufferAllocator::allocate(numDelayLines, 1 + DelayInterpolation::numGuardSamples)),
+      scratchBuffer(numScratchChannels,1)
 {
+    delayLengthValue = parameters.getRawParameterValue(getParameterID(delayLengthParam));
+    dryMixValue = parameters.getRawParameterValue(getParameterID(dryMixParam));
+    wetMixValue = parameters.getRawParameterValue(getParameterID(wetMixParam));
+    feedbackValue = parameters.getRawParameterValue(getParameterID(feedbackParam));
+    crossLengthValue = parameters.getRawParameterValue(getParameterID(crossLengthParam));
+    interpolationValue = parameters.getRawParameterValue(getParameterID(interpolationParam));
+    delayModeValue = parameters.getRawParameterValue(getParameterID(delayModeParam));
+    maxDelayValue = parameters.getRawParameterValue(getParameterID(maxDelayParam));
+    numTapsValue = parameters.getRawParameterValue(getParameterID(numTapsParam));
+    syncValue = parameters.getRawParameterValue(getParameterID(syncParam));
+    divisionValue = parameters.getRawParameterValue(getParameterID(divisionParam));
+    lowCutValue = parameters.getRawParameterValue(getParameterID(lowCutParam));
+    highCutValue = parameters.getRawParameterValue(getParameterID(highCutParam));
+    saturationValue = parameters.getRawParameterValue(getParameterID(saturationParam));
+    driveValue = parameters.getRawParameterValue(getParameterID(driveParam));
+    oversamplingValue = parameters.getRawParameterValue(getParameterID(oversamplingParam));
+    feedbackMatrixValue = parameters.getRawParameterValue(getParameterID(feedbackMatrixParam));
+    crossFeedValue = parameters.getRawParameterValue(getParameterID(crossFeedParam));
+    reverbValue = parameters.getRawParameterValue(getParameterID(reverbParam));
+    reverbSizeValue = parameters.getRawParameterValue(getParameterID(reverbSizeParam));
+    reverbDecayValue = parameters.getRawParameterValue(getParameterID(reverbDecayParam));
+    reverbLevelValue = parameters.getRawParameterValue(getParameterID(reverbLevelParam));
+    duckAmountValue = parameters.getRawParameterValue(getParameterID(duckAmountParam));
+    duckAttackValue = parameters.getRawParameterValue(getParameterID(duckAttackParam));
+    duckReleaseValue = parameters.getRawParameterValue(getParameterID(duckReleaseParam));
+    duckSidechainValue = parameters.getRawParameterValue(getParameterID(duckSidechainParam));
+    lfoShapeValue = parameters.getRawParameterValue(getParameterID(lfoShapeParam));
+    lfoRateValue = parameters.getRawParameterValue(getParameterID(lfoRateParam));
+    lfoDepthValue = parameters.getRawParameterValue(getParameterID(lfoDepthParam));
+    lfoPhaseValue = parameters.getRawParameterValue(getParameterID(lfoPhaseParam));
+    freezeValue = parameters.getRawParameterValue(getParameterID(freezeParam));
+    rightOffsetValue = parameters.getRawParameterValue(getParameterID(rightOffsetParam));
+    for (int t = 0; t < maxNumTaps; ++t)
+    {
+        taps[t].timeValue = parameters.getRawParameterValue(getParameterID(getTapParameterIndex(t, tapTimeParam)));
+        taps[t].gainValue = parameters.getRawParameterValue(getParameterID(getTapParameterIndex(t, tapGainParam)));
+        taps[t].panValue = parameters.getRawParameterValue(getParameterID(getTapParameterIndex(t, tapPanParam)));
+        taps[t].time = taps[t].timeValue->load();
+    }
+
     // set default values
-    delayLength = 0.5;
-    dryMix = 1.0;
-    wetMix = 0.0;
-    feedback = 0.75;
+    delayLength = delayLengthValue->load();
+    rightOffset = rightOffsetValue->load();
     delayBufferLength = 1;
-    crossLength = 1.0;
+    crossLength = crossLengthValue->load();
     crossCount = 1;
-    smoothCurrentCount = 0;
-    smoothWetCurrentCount = 0;
-    smoothFlagGlobal = false;
     
-    delayReadPosition = 0;
+    interpolation = DelayInterpolation::hermite;
+    numInterpolatorStates = 0;
+    maxChunkFrames = 1;
+    numLiveTaps = 0;
+    lowCut = FeedbackFilter::minLowCutHz;
+    highCut = FeedbackFilter::maxHighCutHz;
+    saturation = 0.0f;
+    drive = 0.0f;
+    driving = false;
+    feedbackMatrixMode = FeedbackMatrix::independent;
+    crossFeed = 0.0f;
+    duckSidechain = false;
+    delayMode = crossfadeMode;
+    
     delayWritePosition = 0;
-    prevDelayReadPosition = 0;
+    
+    frozen = false;
+    loopEnd = 0;
+    
+    hostBpm = 120.0;
+    hostNumerator = hostDenominator = 4;
+    syncedBpm = 0.0;
+    syncedNumerator = syncedDenominator = 0;
+    syncedDivision = -1;
+    syncedDelayLength = 0.0f;
+    firstBlock = false;
+    silentSamples = 0;
+    inputPeakHold = 0.0f;
+    idle = false;
     
     lastUIWidth = 370;
     lastUIHeight = 140;
-    //smoothValue = {{}};
 
 }
 
@@ -41,80 +113,212 @@ DynamicDelayAudioProcessor::~DynamicDelayAudioProcessor()
 {
 }
 
-//==============================================================================
-const juce::String DynamicDelayAudioProcessor::getName() const
+juce::AudioProcessorValueTreeState::ParameterLayout DynamicDelayAudioProcessor::createParameterLayout()
 {
-    return JucePlugin_Name;
-}
+    juce::AudioProcessorValueTreeState::ParameterLayout layout;
+    const auto seconds = juce::AudioParameterFloatAttributes().withLabel("s");
+    const auto hertz = juce::AudioParameterFloatAttributes().withLabel("Hz");
+    const auto milliseconds = juce::AudioParameterFloatAttributes().withLabel("ms");
+    const auto degrees = juce::AudioParameterFloatAttributes().withLabel("deg");
+    // delays beyond "max delay" are clamped to it
+    juce::NormalisableRange<float> delayRange(0.01f, maxDelaySeconds, 0.01f);
+    delayRange.setSkewForCentre(1.0f);
 
-int DynamicDelayAudioProcessor::getNumParameters()
-{
-    return numParameters;
+    layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID(getParameterID(delayLengthParam), 1), "delay",
+                                                           delayRange, 0.5f, seconds));
+    layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID(getParameterID(dryMixParam), 1), "dry mix",
+                                                           juce::NormalisableRange<float>(0.0f, 1.0f, 0.01f), 1.0f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID(getParameterID(wetMixParam), 1), "wet mix",
+                                                           juce::NormalisableRange<float>(0.0f, 1.0f, 0.01f), 0.0f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID(getParameterID(feedbackParam), 1), "feedback",
+                                                           juce::NormalisableRange<float>(0.0f, 0.995f, 0.005f), 0.75f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID(getParameterID(crossLengthParam), 1), "cross",
+                                                           juce::NormalisableRange<float>(0.0f, 2.0f, 0.01f), 1.0f, seconds));
+    layout.add(std::make_unique<juce::AudioParameterChoice>(juce::ParameterID(getParameterID(interpolationParam), 1), "interpolation",
+                                                            DelayInterpolation::getNames(), (int) DelayInterpolation::hermite));
+    layout.add(std::make_unique<juce::AudioParameterChoice>(juce::ParameterID(getParameterID(delayModeParam), 1), "mode",
+                                                            getDelayModeNames(), (int) crossfadeMode));
+    layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID(getParameterID(maxDelayParam), 1), "max delay",
+                                                           juce::NormalisableRange<float>(1.0f, maxDelaySeconds, 1.0f), 2.0f, seconds));
+    layout.add(std::make_unique<juce::AudioParameterInt>(juce::ParameterID(getParameterID(numTapsParam), 1), "taps", 0, maxNumTaps, 0));
+    layout.add(std::make_unique<juce::AudioParameterBool>(juce::ParameterID(getParameterID(syncParam), 1), "sync", false));
+    layout.add(std::make_unique<juce::AudioParameterChoice>(juce::ParameterID(getParameterID(divisionParam), 1), "division",
+                                                            getDivisionNames(), 5));
+    // the lowest low cut and the highest high cut leave the feedback unfiltered
+    juce::NormalisableRange<float> lowCutRange(FeedbackFilter::minLowCutHz, 2000.0f, 1.0f);
+    lowCutRange.setSkewForCentre(200.0f);
+    juce::NormalisableRange<float> highCutRange(1000.0f, FeedbackFilter::maxHighCutHz, 1.0f);
+    highCutRange.setSkewForCentre(5000.0f);
+    layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID(getParameterID(lowCutParam), 1), "low cut",
+                                                           lowCutRange, lowCutRange.start, hertz));
+    layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID(getParameterID(highCutParam), 1), "high cut",
+                                                           highCutRange, highCutRange.end, hertz));
+    layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID(getParameterID(saturationParam), 1), "saturation",
+                                                           juce::NormalisableRange<float>(0.0f, 1.0f, 0.01f), 0.0f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID(getParameterID(driveParam), 1), "drive",
+                                                           juce::NormalisableRange<float>(0.0f, 1.0f, 0.01f), 0.0f));
+    layout.add(std::make_unique<juce::AudioParameterChoice>(juce::ParameterID(getParameterID(oversamplingParam), 1), "oversampling",
+                                                            FeedbackDrive::getOversamplingNames(), 1));
+    layout.add(std::make_unique<juce::AudioParameterChoice>(juce::ParameterID(getParameterID(feedbackMatrixParam), 1), "feedback matrix",
+                                                            FeedbackMatrix::getNames(), (int) FeedbackMatrix::independent));
+    layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID(getParameterID(crossFeedParam), 1), "cross-feed",
+                                                           juce::NormalisableRange<float>(0.0f, 1.0f, 0.01f), 0.5f));
+    juce::NormalisableRange<float> reverbDecayRange(0.1f, 20.0f, 0.01f);
+    reverbDecayRange.setSkewForCentre(2.0f);
+    layout.add(std::make_unique<juce::AudioParameterChoice>(juce::ParameterID(getParameterID(reverbParam), 1), "reverb",
+                                                            FdnReverb::getNames(), (int) FdnReverb::off));
+    layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID(getParameterID(reverbSizeParam), 1), "reverb size",
+                                                           juce::NormalisableRange<float>(0.0f, 1.0f, 0.01f), 0.5f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID(getParameterID(reverbDecayParam), 1), "reverb decay",
+                                                           reverbDecayRange, 2.0f, seconds));
+    layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID(getParameterID(reverbLevelParam), 1), "reverb level",
+                                                           juce::NormalisableRange<float>(0.0f, 1.0f, 0.01f), 0.3f));
+    juce::NormalisableRange<float> duckReleaseRange(0.02f, 2.0f, 0.01f);
+    duckReleaseRange.setSkewForCentre(0.25f);
+    layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID(getParameterID(duckAmountParam), 1), "duck",
+                                                           juce::NormalisableRange<float>(0.0f, 1.0f, 0.01f), 0.0f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID(getParameterID(duckAttackParam), 1), "duck attack",
+                                                           juce::NormalisableRange<float>(0.001f, 0.1f, 0.001f), 0.01f, seconds));
+    layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID(getParameterID(duckReleaseParam), 1), "duck release",
+                                                           duckReleaseRange, 0.25f, seconds));
+    layout.add(std::make_unique<juce::AudioParameterBool>(juce::ParameterID(getParameterID(duckSidechainParam), 1), "duck sidechain", false));
+    juce::NormalisableRange<float> lfoRateRange(0.05f, 10.0f, 0.01f);
+    lfoRateRange.setSkewForCentre(1.0f);
+    layout.add(std::make_unique<juce::AudioParameterChoice>(juce::ParameterID(getParameterID(lfoShapeParam), 1), "lfo shape",
+                                                            DelayLfo::getNames(), (int) DelayLfo::sine));
+    layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID(getParameterID(lfoRateParam), 1), "lfo rate",
+                                                           lfoRateRange, 0.5f, hertz));
+    // how far the head swings back, a few ms for chorus and under one for a flanger
+    layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID(getParameterID(lfoDepthParam), 1), "lfo depth",
+                                                           juce::NormalisableRange<float>(0.0f, 20.0f, 0.01f), 0.0f, milliseconds));
+    // each channel is this far ahead of the one before
+    layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID(getParameterID(lfoPhaseParam), 1), "lfo phase",
+                                                           juce::NormalisableRange<float>(0.0f, 180.0f, 1.0f), 90.0f, degrees));
+    layout.add(std::make_unique<juce::AudioParameterBool>(juce::ParameterID(getParameterID(freezeParam), 1), "freeze", false));
+    // the right channel of each pair is this much later than the left, or earlier when negative
+    layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID(getParameterID(rightOffsetParam), 1), "right offset",
+                                                           juce::NormalisableRange<float>(-500.0f, 500.0f, 0.1f), 0.0f, milliseconds));
+    for (int t = 0; t < maxNumTaps; ++t)
+    {
+        const juce::String name = "tap " + juce::String(t + 1);
+        // taps start out spread evenly over the first two seconds
+        layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID(getParameterID(getTapParameterIndex(t, tapTimeParam)), 1), name + " time",
+                                                               delayRange, 0.125f * (float) (t + 1), seconds));
+        layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID(getParameterID(getTapParameterIndex(t, tapGainParam)), 1), name + " gain",
+                                                               juce::NormalisableRange<float>(0.0f, 1.0f, 0.01f), 0.5f));
+        layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID(getParameterID(getTapParameterIndex(t, tapPanParam)), 1), name + " pan",
+                                                               juce::NormalisableRange<float>(-1.0f, 1.0f, 0.01f), 0.0f));
+    }
+    return layout;
 }
 
-float DynamicDelayAudioProcessor::getParameter (int index)
+const char* DynamicDelayAudioProcessor::getParameterID (int index)
 {
+    if (index >= firstTapParam && index < numParameters)
+    {
+        // tap1Time, tap1Gain, tap1Pan, tap2Time...
+        static const juce::StringArray tapIDs = [] {
+            juce::StringArray ids;
+            for (int t = 0; t < maxNumTaps; ++t)
+            {
+                ids.add("tap" + juce::String(t + 1) + "Time");
+                ids.add("tap" + juce::String(t + 1) + "Gain");
+                ids.add("tap" + juce::String(t + 1) + "Pan");
+            }
+            return ids;
+        }();
+        return tapIDs[index - firstTapParam].toRawUTF8();
+    }
+    
     switch (index) {
+        case delayLengthParam:
+            return "delayLength";
         case dryMixParam:
-            return dryMix;
+            return "dryMix";
         case wetMixParam:
-            return wetMix;
+            return "wetMix";
         case feedbackParam:
-            return feedback;
-        case delayLengthParam:
-            return delayLength;
+            return "feedback";
         case crossLengthParam:
-            return crossLength;
+            return "crossLength";
+        case interpolationParam:
+            return "interpolation";
+        case delayModeParam:
+            return "delayMode";
+        case maxDelayParam:
+            return "maxDelay";
+        case numTapsParam:
+            return "numTaps";
+        case syncParam:
+            return "sync";
+        case divisionParam:
+            return "division";
+        case lowCutParam:
+            return "lowCut";
+        case highCutParam:
+            return "highCut";
+        case saturationParam:
+            return "saturation";
+        case driveParam:
+            return "drive";
+        case oversamplingParam:
+            return "oversampling";
+        case feedbackMatrixParam:
+            return "feedbackMatrix";
+        case crossFeedParam:
+            return "crossFeed";
+        case reverbParam:
+            return "reverb";
+        case reverbSizeParam:
+            return "reverbSize";
+        case reverbDecayParam:
+            return "reverbDecay";
+        case reverbLevelParam:
+            return "reverbLevel";
+        case duckAmountParam:
+            return "duckAmount";
+        case duckAttackParam:
+            return "duckAttack";
+        case duckReleaseParam:
+            return "duckRelease";
+        case duckSidechainParam:
+            return "duckSidechain";
+        case lfoShapeParam:
+            return "lfoShape";
+        case lfoRateParam:
+            return "lfoRate";
+        case lfoDepthParam:
+            return "lfoDepth";
+        case lfoPhaseParam:
+            return "lfoPhase";
+        case freezeParam:
+            return "freeze";
+        case rightOffsetParam:
+            return "rightOffset";
         default:
-            return 0.0f;
+            return "";
     }
 }
 
-void DynamicDelayAudioProcessor::setParameter (int index, float newValue)
+juce::StringArray DynamicDelayAudioProcessor::getDelayModeNames()
 {
-    switch (index) {
-        case dryMixParam:
-            dryMix = newValue;
-            break;
-        case wetMixParam:
-            wetMix = newValue;
-            break;
-        case feedbackParam:
-            feedback = newValue;
-            break;
-        case delayLengthParam:
-            delayLength = newValue;
-            delayReadPosition = (int) (delayWritePosition - (delayLength * getSampleRate()) + delayBufferLength) % delayBufferLength;
-            break;
-        case crossLengthParam:
-            crossLength = newValue;
-            crossCount = (int) (crossLength * getSampleRate());
-            //smoothCurrentCount = 0;
-            break;
-        default:
-            break;
-    }
+    return { "crossfade", "glide" };
 }
 
-const juce::String DynamicDelayAudioProcessor::getParameterName (int index)
+// note lengths in quarter notes, in the order of getDivisionNames(), a bar is worked out from the time signature
+static const double divisionLengths[] = { 0.0, 4.0, 2.0, 3.0, 4.0 / 3.0, 1.0, 1.5, 2.0 / 3.0,
+                                          0.5, 0.75, 1.0 / 3.0, 0.25, 0.375, 1.0 / 6.0, 0.125 };
+
+juce::StringArray DynamicDelayAudioProcessor::getDivisionNames()
 {
-    switch (index) {
-        case dryMixParam:
-            return "dry mix";
-        case wetMixParam:
-            return "wet mix";
-        case feedbackParam:
-            return "feedback";
-        case delayLengthParam:
-            return "delay";
-        default:
-            return juce::String::String();
-    }
+    return { "1 bar", "1/1", "1/2", "1/2 dotted", "1/2 triplet", "1/4", "1/4 dotted", "1/4 triplet",
+             "1/8", "1/8 dotted", "1/8 triplet", "1/16", "1/16 dotted", "1/16 triplet", "1/32" };
 }
 
-const juce::String DynamicDelayAudioProcessor::getParameterText (int index)
+//==============================================================================
+const juce::String DynamicDelayAudioProcessor::getName() const
 {
-    return juce::String();
+    return JucePlugin_Name;
 }
 
 const juce::String DynamicDelayAudioProcessor::getInputChannelName (int channelIndex) const
@@ -137,6 +341,18 @@ bool DynamicDelayAudioProcessor::isOutputChannelStereoPair (int index) const
     return true;
 }
 
+bool DynamicDelayAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) const
+{
+    // any layout up to maxNumChannels, as long as the output matches the input,
+    // and a mono or stereo sidechain if the host connects one
+    const juce::AudioChannelSet& mainOutput = layouts.getMainOutputChannelSet();
+    const bool sidechainSupported = layouts.inputBuses.size() < 2 || layouts.getChannelSet(true, 1).size() <= 2;
+    return ! mainOutput.isDisabled()
+        && mainOutput.size() <= maxNumChannels
+        && mainOutput == layouts.getMainInputChannelSet()
+        && sidechainSupported;
+}
+
 bool DynamicDelayAudioProcessor::acceptsMidi() const
 {
    #if JucePlugin_WantsMidiInput
@@ -162,7 +378,30 @@ bool DynamicDelayAudioProcessor::silenceInProducesSilenceOut() const
 
 double DynamicDelayAudioProcessor::getTailLengthSeconds() const
 {
-    return 0.0;
+    // a synced delay depends on the tempo the audio thread sees, so the longest one is assumed,
+    // the right channels may be later by their offset, and the LFO may hold the heads back by its depth on top
+    const double delaySeconds = (syncValue->load() >= 0.5f ? maxDelayValue->load() : delayLengthValue->load())
+                              + (juce::jmax(0.0f, rightOffsetValue->load()) + lfoDepthValue->load()) * 0.001;
+    double longestTapSeconds = 0.0;
+    for (int t = 0; t < (int) numTapsValue->load(); ++t)
+        if (taps[t].gainValue->load() > 0.0f)
+            longestTapSeconds = juce::jmax(longestTapSeconds, (double) taps[t].timeValue->load());
+    const double delayTail = getDecaySeconds(delaySeconds, feedbackValue->load(), longestTapSeconds,
+                                             FeedbackMatrix::getPeakGain((int) feedbackMatrixValue->load(), numDelayChannels));
+    return juce::jmax(delayTail, FdnReverb::getTailSeconds((int) reverbValue->load(), reverbDecayValue->load(), 1.0, silenceThreshold));
+}
+
+double DynamicDelayAudioProcessor::getDecaySeconds (double delaySeconds, double feedback, double longestTapSeconds, double peak)
+{
+    // Every trip round the loop takes delaySeconds and scales the signal by
+    // feedback, so a signal at peak needs log(threshold / peak) / log(feedback)
+    // trips to fall below the threshold. The filters, the saturator and the
+    // drive only ever take level out, so this is an upper bound. Taps hear
+    // the last trip up to longestTapSeconds later.
+    int repeats = 0;
+    if (feedback > 0.0 && peak > silenceThreshold)
+        repeats = (int) std::ceil(std::log(silenceThreshold / peak) / std::log(juce::jmin(feedback, 0.9999)));
+    return delaySeconds * repeats + juce::jmax(delaySeconds, longestTapSeconds);
 }
 
 int DynamicDelayAudioProcessor::getNumPrograms()
@@ -194,106 +433,865 @@ void DynamicDelayAudioProcessor::prepareToPlay (double sampleRate, int samplesPe
 {
     // Use this method as the place to do any pre-playback
     // initialisation that you need..
-    delayBufferLength  = (int) (2.0 * sampleRate);
+    syncedDivision = -1;
+    firstBlock = true;
+    silentSamples = 0;
+    inputPeakHold = 0.0f;
+    idle = false;
+    delayLength = getDelayTime();
+    rightOffset = rightOffsetValue->load();
+    crossLength = crossLengthValue->load();
+    interpolation = (int) interpolationValue->load();
+    delayMode = (int) delayModeValue->load();
     crossCount = (int) (crossLength * sampleRate);
-    if (delayBufferLength < 1)
-        delayBufferLength = 1;
     if (crossCount < 1)
         crossCount = 1;
-    delayBuffer.setSize(2, delayBufferLength);
-    delayBuffer.clear();
+    // the sidechain only drives the ducking, it gets no delay line
+    numDelayChannels = juce::jmax(1, getMainBusNumInputChannels());
+    numDelayLanes = interleavedDelayStore ? numDelayChannels : 1;
+    numDelayLines = numDelayChannels / numDelayLanes;
+    // the read heads' interpolator states come first, then the cross heads'
+    numInterpolatorStates = 2 * numDelayChannels;
+    interpolatorState.calloc((size_t) numInterpolatorStates);
+    tapInterpolatorState.calloc((size_t) (maxNumTaps * numInterpolatorStates));
+    feedbackFilterState.calloc((size_t) (2 * numDelayChannels));
+    lowCut = lowCutValue->load();
+    highCut = highCutValue->load();
+    saturation = saturationValue->load();
+    feedbackFilter.setCutoffs(sampleRate, lowCut, highCut);
+    maxChunkFrames = juce::jmax(samplesPerBlock, 1);
+    // The drive's latency stays inside the loop, so the output is never late
+    // and there is nothing to report with setLatencySamples().
+    feedbackDrive.prepare(numDelayChannels, maxChunkFrames);
+    feedbackDrive.setOversampling((int) oversamplingValue->load());
+    drive = driveValue->load();
+    feedbackMatrixMode = (int) feedbackMatrixValue->load();
+    crossFeed = crossFeedValue->load();
+    feedbackMatrix.setMatrix(feedbackMatrixMode, numDelayChannels, crossFeed);
+    fdnReverb.prepare(sampleRate, numDelayChannels, maxChunkFrames);
+    fdnReverb.setNetwork((int) reverbValue->load());
+    fdnReverb.setSize(reverbSizeValue->load(), crossCount);
+    fdnReverb.setDecay(reverbDecayValue->load());
+    reverbLevelRamp.reset(sampleRate, parameterRampSeconds, reverbLevelValue->load(), ParameterRamp::multiplicative);
+    ducker.prepare(sampleRate);
+    ducker.setAmount(duckAmountValue->load());
+    ducker.setTimes(duckAttackValue->load(), duckReleaseValue->load());
+    duckSidechain = duckSidechainValue->load() >= 0.5f;
+    delayLfo.prepare(sampleRate, (int) (sampleRate * parameterRampSeconds));
+    scratchBuffer.setSize(numScratchChannels, maxChunkFrames * numDelayLanes);
+    feedbackBuffer.setSize(numDelayLines, maxChunkFrames * numDelayLanes);
+    tapGainBuffer.setSize(2 * maxNumTaps, maxChunkFrames);
+    dryMixRamp.reset(sampleRate, parameterRampSeconds, dryMixValue->load(), ParameterRamp::multiplicative);
+    wetMixRamp.reset(sampleRate, parameterRampSeconds, wetMixValue->load(), ParameterRamp::multiplicative);
+    feedbackRamp.reset(sampleRate, parameterRampSeconds, feedbackValue->load(), ParameterRamp::multiplicative);
+    const int numTaps = (int) numTapsValue->load();
+    for (int t = 0; t < maxNumTaps; ++t)
+    {
+        taps[t].time = taps[t].timeValue->load();
+        taps[t].gainRamp.reset(sampleRate, parameterRampSeconds, t < numTaps ? taps[t].gainValue->load() : 0.0f,
+                               ParameterRamp::multiplicative);
+        taps[t].panRamp.reset(sampleRate, parameterRampSeconds, taps[t].panValue->load());
+    }
+    numLiveTaps = 0;
+    
+    // the first buffer is built here, later changes of the maximum come from the allocator
+    delayBufferAllocator.stop();
+    const int delayBufferSize = delayBufferSizeFor(maxDelayValue->load());
+    delayBuffer.reset();
+    swapInDelayBuffer(DelayBufferAllocator::allocate(numDelayLines, delayBufferSize));
+    delayBufferAllocator.start(numDelayLines, delayBufferSize);
+}
+
+int DynamicDelayAudioProcessor::delayBufferSizeFor (float maxDelaySeconds) const
+{
+    // room for the delay plus the interpolation window around it, and the guard
+    // frames mirroring the start of the line, in floats per line
+    const int length = (int) (maxDelaySeconds * getSampleRate()) + DelayInterpolation::numGuardSamples + 1;
+    return (juce::jmax(1, length) + DelayInterpolation::numGuardSamples) * numDelayLanes;
+}
+
+std::unique_ptr<juce::AudioSampleBuffer> DynamicDelayAudioProcessor::swapInDelayBuffer (std::unique_ptr<juce::AudioSampleBuffer> newBuffer)
+{
+    // A new maximum delay keeps what the line holds, as far as it fits. The
+    // first buffer after prepareToPlay has nothing to keep and starts silent.
+    std::unique_ptr<juce::AudioSampleBuffer> oldBuffer = std::move(delayBuffer);
+    const int oldLength = delayBufferLength;
+    delayBuffer = std::move(newBuffer);
+    delayBufferLength = delayBuffer->getNumSamples() / numDelayLanes - DelayInterpolation::numGuardSamples;
+    delaySummary.reset(delayBufferLength);
+    if (oldBuffer != nullptr && oldBuffer->getNumChannels() == delayBuffer->getNumChannels())
+        carryDelayHistory(*oldBuffer, oldLength);
+    else
+        resetDelayLine();
+    return oldBuffer;
+}
+
+void DynamicDelayAudioProcessor::carryDelayHistory (const juce::AudioSampleBuffer& oldBuffer, int oldLength)
+{
+    // The most recent frames that fit go to the start of the new line. They
+    // end at the write head, or while frozen where the loops end, since the
+    // write head has stopped writing there.
+    const int numGuardSamples = DelayInterpolation::numGuardSamples;
+    const int oldAnchor = frozen ? (loopEnd + numGuardSamples + 1) % oldLength : delayWritePosition;
+    const int numFrames = juce::jmin(oldLength, delayBufferLength);
+    const int newAnchor = numFrames % delayBufferLength;
+    const int firstFrame = (oldAnchor - numFrames + oldLength) % oldLength;
+    const int numFirstFrames = juce::jmin(numFrames, oldLength - firstFrame);
+    for (int line = 0; line < numDelayLines; ++line) {
+        const float* oldData = oldBuffer.getReadPointer(line);
+        float* newData = delayBuffer->getWritePointer(line);
+        juce::FloatVectorOperations::copy(newData, oldData + firstFrame * numDelayLanes, numFirstFrames * numDelayLanes);
+        juce::FloatVectorOperations::copy(newData + numFirstFrames * numDelayLanes, oldData, (numFrames - numFirstFrames) * numDelayLanes);
+        juce::FloatVectorOperations::copy(newData + delayBufferLength * numDelayLanes, newData, numGuardSamples * numDelayLanes);
+        delaySummary.add(newData, 0, numFrames, numDelayLanes, line == 0);
+    }
+
+    // Every position keeps its distance behind the write head, or a loop's
+    // behind the anchor. One further back than the new line reaches is lost.
+    const int oldWritePosition = delayWritePosition;
+    delayWritePosition = (newAnchor + (oldWritePosition - oldAnchor + oldLength) % oldLength) % delayBufferLength;
+    const int maxDistance = delayBufferLength - numGuardSamples - 1;
+    auto carry = [&] (int& position, int oldFrom, int newFrom)
+    {
+        const int distance = (oldFrom - position + oldLength) % oldLength;
+        position = (newFrom - juce::jmin(distance, maxDistance) + delayBufferLength) % delayBufferLength;
+        return distance <= maxDistance;
+    };
+
+    // A head whose place is lost is put back on its delay, fading from where
+    // it was if that is still there. One whose old place is lost only hears
+    // the new one. Delays past the new maximum are clamped like a delay change.
+    for (ReadHead& head : readHeads)
+    {
+        if (carry(head.position, oldWritePosition, delayWritePosition) == false)
+            head.fading = false;
+        if (carry(head.crossPosition, oldWritePosition, delayWritePosition) == false)
+            head.fading = false;
+        const bool prevKept = carry(head.prevPosition, oldWritePosition, delayWritePosition);
+        head.glideDelaySamples = clampDelaySamples(head.glideDelaySamples);
+        if (prevKept == false)
+        {
+            head.prevPosition = head.position;
+            head.prevFraction = head.fraction;
+        }
+    }
+    setReadPositionsForDelay();
+
+    // a loop that no longer fits starts again from the new line on the next block
+    if (frozen)
+    {
+        bool loopsFit = true;
+        for (int channel = 0; channel < numDelayChannels; ++channel) {
+            ReadHead& head = readHeads[channel];
+            loopsFit = loopsFit && head.loopLength + head.loopFade + numGuardSamples + 2 <= maxDistance
+                && carry(head.loopPosition, oldAnchor, newAnchor) && carry(head.loopCrossPosition, oldAnchor, newAnchor);
+        }
+        loopEnd = (newAnchor - numGuardSamples - 1 + delayBufferLength) % delayBufferLength;
+        if (loopsFit == false)
+        {
+            frozen = false;
+            for (ReadHead& head : readHeads)
+                head.loopFading = false;
+        }
+    }
+
+    for (DelayTap& tap : taps)
+    {
+        if (carry(tap.heads.position, oldWritePosition, delayWritePosition) == false)
+        {
+            setTapPosition(tap);
+            tap.heads.fading = false;
+        }
+        if (carry(tap.heads.crossPosition, oldWritePosition, delayWritePosition) == false)
+            tap.heads.fading = false;
+        if (carry(tap.prevPosition, oldWritePosition, delayWritePosition) == false)
+        {
+            tap.prevPosition = tap.heads.position;
+            tap.prevFraction = tap.fraction;
+        }
+    }
+}
+
+void DynamicDelayAudioProcessor::resetDelayLine()
+{
+    // a new buffer starts out silent, with every head back in place
+    delayWritePosition = 0;
+    for (ReadHead& head : readHeads)
+        head.fading = false;
+    setReadPositionsForDelay();
+    for (ReadHead& head : readHeads)
+    {
+        head.movePending = false;
+        head.prevPosition = head.position;
+        head.prevFraction = head.fraction;
+        head.crossPosition = head.position;
+        head.crossFraction = head.fraction;
+        head.fadeCount = 0;
+        head.glideDelaySamples = head.delaySamples;
+        head.glideStep = 0.0;
+        head.loopFading = false;
+    }
+    // a frozen loop has nothing to play on a new line, it starts again on the next block
+    frozen = false;
+    juce::FloatVectorOperations::clear(interpolatorState.get(), numInterpolatorStates);
+    juce::FloatVectorOperations::clear(feedbackFilterState.get(), 2 * numDelayChannels);
+    // the drive is primed again on the silent line before it next runs
+    driving = false;
     
-    delayReadPosition = (int) (delayWritePosition - (delayLength * getSampleRate()) + delayBufferLength) % delayBufferLength;
-    prevDelayReadPosition = delayReadPosition;
-    smoothCurrentCount = 0;
-    smoothWetCurrentCount = 0;
+    for (DelayTap& tap : taps)
+    {
+        setTapPosition(tap);
+        tap.prevPosition = tap.heads.position;
+        tap.prevFraction = tap.fraction;
+        tap.heads.fading = false;
+        tap.heads.fadeCount = 0;
+    }
+    juce::FloatVectorOperations::clear(tapInterpolatorState.get(), maxNumTaps * numInterpolatorStates);
+}
+
+void DynamicDelayAudioProcessor::primeFeedbackDrive()
+{
+    // what each main head read last, times the feedback, is what the drive is about to be fed
+    int ends[maxNumChannels];
+    for (int channel = 0; channel < numDelayChannels; ++channel) {
+        const ReadHead& head = readHeads[channel];
+        ends[channel] = head.position;
+        if (delayMode == glideMode)
+        {
+            float fraction;
+            positionForDelay(head.glideDelaySamples, ends[channel], fraction);
+        }
+    }
+    float* scratch = scratchBuffer.getWritePointer(driveScratch);
+    for (int line = 0; line < numDelayLines; ++line)
+        feedbackDrive.prime(delayBuffer->getReadPointer(line), delayBufferLength, ends + line * numDelayLanes,
+                            numDelayLanes, line * numDelayLanes, feedbackRamp.getCurrentValue(), drive, scratch);
+}
+
+void DynamicDelayAudioProcessor::flushFeedbackDrive()
+{
+    float* scratch = scratchBuffer.getWritePointer(driveScratch);
+    for (int line = 0; line < numDelayLines; ++line) {
+        float* delayData = delayBuffer->getWritePointer(line);
+        feedbackDrive.flush(delayData, delayBufferLength, delayWritePosition, numDelayLanes, line * numDelayLanes, drive, scratch);
+        // the frames it finished may be mirrored past the end
+        juce::FloatVectorOperations::copy(delayData + delayBufferLength * numDelayLanes, delayData,
+                                          DelayInterpolation::numGuardSamples * numDelayLanes);
+    }
+}
+
+double DynamicDelayAudioProcessor::getChannelDelaySamples (int channel) const
+{
+    // the right of each channel pair is offset, like the taps pan odd channels right
+    const double seconds = (channel & 1) != 0 ? delayLength + rightOffset * 0.001 : (double) delayLength;
+    return clampDelaySamples(seconds * getSampleRate());
+}
+
+void DynamicDelayAudioProcessor::setReadPositionsForDelay()
+{
+    for (int channel = 0; channel < maxNumChannels; ++channel) {
+        ReadHead& head = readHeads[channel];
+        head.delaySamples = getChannelDelaySamples(channel);
+        // a head fading in keeps its place, moving it would click
+        if (head.fading)
+            head.movePending = true;
+        else
+            positionForDelay(head.delaySamples, head.position, head.fraction);
+    }
+}
+
+bool DynamicDelayAudioProcessor::isAnyHeadFading() const
+{
+    for (int channel = 0; channel < numDelayChannels; ++channel)
+        if (readHeads[channel].fading)
+            return true;
+    return false;
+}
+
+void DynamicDelayAudioProcessor::updateHostTempo()
+{
+    juce::AudioPlayHead* playHead = getPlayHead();
+    if (playHead == nullptr)
+        return;
+    
+    const juce::Optional<juce::AudioPlayHead::PositionInfo> position = playHead->getPosition();
+    if (! position)
+        return;
+    
+    // hosts that leave the tempo out keep the last one they reported
+    if (const juce::Optional<double> bpm = position->getBpm())
+        if (*bpm > 0.0)
+            hostBpm = *bpm;
+    if (const juce::Optional<juce::AudioPlayHead::TimeSignature> timeSignature = position->getTimeSignature())
+        if (timeSignature->numerator > 0 && timeSignature->denominator > 0)
+        {
+            hostNumerator = timeSignature->numerator;
+            hostDenominator = timeSignature->denominator;
+        }
+}
+
+float DynamicDelayAudioProcessor::getDelayTime()
+{
+    if (syncValue->load() < 0.5f)
+        return delayLengthValue->load();
+    
+    const int division = juce::jlimit(0, juce::numElementsInArray(divisionLengths) - 1, (int) divisionValue->load());
+    if (hostBpm != syncedBpm || hostNumerator != syncedNumerator || hostDenominator != syncedDenominator || division != syncedDivision)
+    {
+        syncedBpm = hostBpm;
+        syncedNumerator = hostNumerator;
+        syncedDenominator = hostDenominator;
+        syncedDivision = division;
+        const double quarterNotes = division == 0 ? 4.0 * hostNumerator / hostDenominator : divisionLengths[division];
+        syncedDelayLength = (float) juce::jlimit(0.01, (double) maxDelaySeconds, quarterNotes * 60.0 / hostBpm);
+    }
+    return syncedDelayLength;
+}
+
+void DynamicDelayAudioProcessor::setTapPosition (DelayTap& tap)
+{
+    positionForDelay(clampDelaySamples(tap.time * getSampleRate()), tap.heads.position, tap.fraction);
+}
+
+double DynamicDelayAudioProcessor::clampDelaySamples (double samples) const
+{
+    // keep the whole interpolation window behind the write head, and behind
+    // where the drive writes back, whatever oversampling is picked
+    const double minDelaySamples = (double) (DelayInterpolation::numGuardSamples + feedbackDrive.getMaxLatency());
+    const double maxDelaySamples = (double) (delayBufferLength - DelayInterpolation::numGuardSamples - 1);
+    return juce::jlimit(minDelaySamples, juce::jmax(minDelaySamples, maxDelaySamples), samples);
+}
+
+void DynamicDelayAudioProcessor::positionForDelay (double samples, int& position, float& fraction) const
+{
+    double exactPosition = delayWritePosition - samples;
+    if (exactPosition < 0)
+        exactPosition += delayBufferLength;
+    position = juce::jmin((int) exactPosition, delayBufferLength - 1);
+    fraction = (float) (exactPosition - position);
+}
+
+int DynamicDelayAudioProcessor::framesBeforeUnmixedReads (int driveLatency) const
+{
+    // The frames from where the drive adds its feedback on only get their
+    // feedback at the end of the chunk, so the chunk has to end before any
+    // head reads them. Undriven, that is the write head.
+    int limit = delayWritePosition - driveLatency;
+    if (limit < 0)
+        limit += delayBufferLength;
+
+    int frames = delayBufferLength;
+    for (int channel = 0; channel < numDelayChannels; ++channel) {
+        const ReadHead& head = readHeads[channel];
+        if (delayMode == glideMode)
+            frames = juce::jmin(frames, (int) juce::jmin(head.glideDelaySamples, head.delaySamples) - driveLatency - DelayInterpolation::numGuardSamples + 1);
+        else
+            frames = juce::jmin(frames, distanceToWriteHead(wrapPosition(windowStart(head.position) + DelayInterpolation::numGuardSamples), limit));
+        if (head.fading)
+            frames = juce::jmin(frames, distanceToWriteHead(wrapPosition(windowStart(head.crossPosition) + DelayInterpolation::numGuardSamples), limit));
+    }
+    for (int k = 0; k < numLiveTaps; ++k)
+    {
+        const DelayTap::Heads& heads = taps[liveTaps[k]].heads;
+        frames = juce::jmin(frames, distanceToWriteHead(wrapPosition(windowStart(heads.position) + DelayInterpolation::numGuardSamples), limit));
+        if (heads.fading)
+            frames = juce::jmin(frames, distanceToWriteHead(wrapPosition(windowStart(heads.crossPosition) + DelayInterpolation::numGuardSamples), limit));
+    }
+    return juce::jmax(1, frames);
+}
+
+void DynamicDelayAudioProcessor::addFeedback (int line, const float* feedback, int writePosition, int numFrames)
+{
+    // Driven, what comes out of the drive is the feedback of the frames
+    // driveLatency behind writePosition. Neither run may wrap.
+    const int numLanes = numDelayLanes;
+    float* delayData = delayBuffer->getWritePointer(line);
+    int position = writePosition;
+    if (driving)
+    {
+        position -= feedbackDrive.getLatency();
+        if (position < 0)
+            position += delayBufferLength;
+        feedbackDrive.process(feedback, delayData + position * numLanes, numFrames, numLanes, line * numLanes, drive,
+                              scratchBuffer.getWritePointer(driveScratch));
+    }
+    else
+    {
+        juce::FloatVectorOperations::add(delayData + position * numLanes, feedback, numFrames * numLanes);
+    }
+
+    // the frames from position on are final
+    const float* finalData = delayData + position * numLanes;
+    if (position < DelayInterpolation::numGuardSamples)
+        juce::FloatVectorOperations::copy(delayData + (delayBufferLength + position) * numLanes, finalData,
+                                          juce::jmin(numFrames, DelayInterpolation::numGuardSamples - position) * numLanes);
+    loopMeter.add(finalData, numFrames * numLanes);
+    delaySummary.add(finalData, position, numFrames, numLanes, line == 0);
+}
+
+void DynamicDelayAudioProcessor::mixFeedback (int writePosition, int numFrames)
+{
+    // every line's feedback for the chunk is mixed in place...
+    if (numDelayLanes > 1)
+    {
+        feedbackMatrix.process(feedbackBuffer.getWritePointer(0), numFrames);
+    }
+    else
+    {
+        float* lines[maxNumChannels];
+        for (int line = 0; line < numDelayLines; ++line)
+            lines[line] = feedbackBuffer.getWritePointer(line);
+        feedbackMatrix.processLines(lines, numFrames);
+    }
+
+    // ...and added to the input written from writePosition on, in runs where
+    // neither the write head nor where the drive adds wraps
+    const int driveLatency = driving ? feedbackDrive.getLatency() : 0;
+    for (int done = 0; done < numFrames;) {
+        const int position = wrapPosition(writePosition + done);
+        const int drivePosition = position >= driveLatency ? position - driveLatency : position - driveLatency + delayBufferLength;
+        const int n = juce::jmin(numFrames - done, delayBufferLength - position, delayBufferLength - drivePosition);
+        for (int line = 0; line < numDelayLines; ++line)
+            addFeedback(line, feedbackBuffer.getReadPointer(line, done * numDelayLanes), position, n);
+        done += n;
+    }
+}
+
+void DynamicDelayAudioProcessor::startFreeze()
+{
+    // Each loop runs from its read head to the last final frame, short of the
+    // write head by the drive's latency and the interpolation window.
+    loopEnd = delayWritePosition - (driving ? feedbackDrive.getLatency() : 0) - DelayInterpolation::numGuardSamples;
+    if (loopEnd < 0)
+        loopEnd += delayBufferLength;
+    for (int channel = 0; channel < numDelayChannels; ++channel) {
+        ReadHead& head = readHeads[channel];
+        if (delayMode == glideMode)
+        {
+            positionForDelay(head.glideDelaySamples, head.loopPosition, head.loopFraction);
+        }
+        else
+        {
+            head.loopPosition = head.position;
+            head.loopFraction = head.fraction;
+        }
+        head.loopCrossPosition = head.loopPosition;
+        head.loopLength = juce::jmax(1, (loopEnd - head.loopPosition + delayBufferLength) % delayBufferLength);
+        // the loop points fade over the cross time, as long as that fits in the
+        // loop, and in the line before the loop where the jump lands
+        head.loopFade = juce::jlimit(0, juce::jmax(0, delayBufferLength - head.loopLength - DelayInterpolation::numGuardSamples - 1),
+                                     juce::jmin(crossCount, head.loopLength / 2));
+        head.loopFadeCount = 0;
+        head.loopFading = false;
+    }
+    frozen = true;
+}
+
+void DynamicDelayAudioProcessor::stopFreeze()
+{
+    // each read head fades or glides back from wherever its loop got to
+    frozen = false;
+    for (int channel = 0; channel < numDelayChannels; ++channel) {
+        ReadHead& head = readHeads[channel];
+        if (delayMode == glideMode)
+        {
+            head.glideDelaySamples = getLoopDelaySamples(head);
+            head.glideStep = juce::jmin(maxGlideSpeed, std::abs(head.delaySamples - head.glideDelaySamples) / crossCount);
+        }
+        else
+        {
+            head.fading = true;
+            head.fadeCount = 0;
+            head.crossPosition = head.loopPosition;
+            head.crossFraction = head.loopFraction;
+            head.prevPosition = head.position;
+            head.prevFraction = head.fraction;
+        }
+    }
+    if (delayMode == crossfadeMode)
+        juce::FloatVectorOperations::copy(interpolatorState + numDelayChannels, interpolatorState, numDelayChannels);
+}
+
+double DynamicDelayAudioProcessor::getLoopDelaySamples (const ReadHead& head) const
+{
+    const double delay = delayWritePosition - (head.loopPosition + (double) head.loopFraction);
+    return delay > 0.0 ? delay : delay + delayBufferLength;
+}
+
+int DynamicDelayAudioProcessor::windowStart (int readPosition) const
+{
+    return readPosition > 0 ? readPosition - 1 : delayBufferLength - 1;
+}
+
+int DynamicDelayAudioProcessor::wrapPosition (int position) const
+{
+    return position >= delayBufferLength ? position - delayBufferLength : position;
+}
+
+int DynamicDelayAudioProcessor::distanceToWriteHead (int readPosition, int writePosition) const
+{
+    // a head sitting on the write position reads each sample before it is overwritten
+    const int distance = (writePosition - readPosition + delayBufferLength) % delayBufferLength;
+    return distance > 0 ? distance : delayBufferLength;
 }
 
 void DynamicDelayAudioProcessor::releaseResources()
 {
     // When playback stops, you can use this as an opportunity to free up any
     // spare memory, etc.
+    delayBufferAllocator.stop();
+}
+
+static void snapToZero (float* values, int numValues) noexcept
+{
+    for (int i = 0; i < numValues; ++i)
+        JUCE_SNAP_TO_ZERO (values[i]);
 }
 
 void DynamicDelayAudioProcessor::processBlock (juce::AudioSampleBuffer& buffer, juce::MidiBuffer& midiMessages)
 {
-    const int numInputChannels = getNumInputChannels();
-    const int numOutputChannels = getNumOutputChannels();
+    // A fading repeat recirculates until it reaches the denormal range, where
+    // every multiply in the loop gets many times slower. Flushing them to zero
+    // keeps the loop's cost flat all the way down.
+    juce::ScopedNoDenormals noDenormals;
+    const int numInputChannels = getMainBusNumInputChannels();
+    const int numOutputChannels = getMainBusNumOutputChannels();
     const int numSamples = buffer.getNumSamples();
-    std::vector<float> templist;
+    
+    inputMeter.reset();
+    wetMeter.reset();
+    loopMeter.reset();
+    for (int channel = 0; channel < juce::jmin(numInputChannels, buffer.getNumChannels()); ++channel)
+        inputMeter.add(buffer.getReadPointer(channel), numSamples);
+    const float inputPeak = inputMeter.peak;
+
+    // Pick up parameter changes published by the host or the editor. A new
+    // delay time moves the read heads, which starts their crossfades below.
+    // A new maximum delay swaps in a buffer of the new size once the allocator
+    // has built it. Offline there is no deadline, so it is built right here.
+    const int delayBufferSize = delayBufferSizeFor(maxDelayValue->load());
+    if (isNonRealtime())
+    {
+        if (delayBufferSize != delayBuffer->getNumSamples())
+            swapInDelayBuffer(DelayBufferAllocator::allocate(numDelayLines, delayBufferSize));
+    }
+    else
+    {
+        delayBufferAllocator.request(numDelayLines, delayBufferSize);
+        if (juce::AudioSampleBuffer* newBuffer = delayBufferAllocator.takePending())
+        {
+            // a buffer built for an older request is handed straight back
+            if (newBuffer->getNumSamples() == delayBufferSize && delayBufferSize != delayBuffer->getNumSamples())
+            {
+                delayBufferAllocator.retire(swapInDelayBuffer(std::unique_ptr<juce::AudioSampleBuffer>(newBuffer)).release());
+            }
+            else
+            {
+                delayBufferAllocator.retire(newBuffer);
+            }
+        }
+    }
 
-    int dpr, dpw, prevdpr, smoothCount, smoothWetCount;
-    bool smoothFlag;
+    // A synced delay time changes with the host tempo, and goes through the
+    // same crossfade or glide as a change of the delay parameter.
+    updateHostTempo();
+    const float newDelayLength = getDelayTime();
+    if (firstBlock)
+    {
+        // The playhead can only be asked once playback runs, so the first block
+        // puts the read heads straight on the host's tempo. Nothing has been
+        // written yet, so there is nothing to fade from.
+        firstBlock = false;
+        if (newDelayLength != delayLength)
+        {
+            delayLength = newDelayLength;
+            resetDelayLine();
+        }
+    }
+    const float newRightOffset = rightOffsetValue->load();
+    if (newDelayLength != delayLength || newRightOffset != rightOffset)
+    {
+        delayLength = newDelayLength;
+        rightOffset = newRightOffset;
+        setReadPositionsForDelay();
+        // in glide mode each read head travels to its new delay time over the
+        // cross time, but never faster than maxGlideSpeed
+        for (ReadHead& head : readHeads)
+            head.glideStep = juce::jmin(maxGlideSpeed, std::abs(head.delaySamples - head.glideDelaySamples) / crossCount);
+    }
+    const float newCrossLength = crossLengthValue->load();
+    if (newCrossLength != crossLength)
+    {
+        crossLength = newCrossLength;
+        crossCount = juce::jmax(1, (int) (crossLength * getSampleRate()));
+    }
+    dryMixRamp.setTargetValue(dryMixValue->load());
+    wetMixRamp.setTargetValue(wetMixValue->load());
+    feedbackRamp.setTargetValue(feedbackValue->load());
+    // the filter coefficients are held for the block
+    if (lowCutValue->load() != lowCut || highCutValue->load() != highCut)
+    {
+        lowCut = lowCutValue->load();
+        highCut = highCutValue->load();
+        feedbackFilter.setCutoffs(getSampleRate(), lowCut, highCut);
+    }
+    saturation = saturationValue->load();
+    // the routing between the channels is held for the block
+    if ((int) feedbackMatrixValue->load() != feedbackMatrixMode || crossFeedValue->load() != crossFeed)
+    {
+        feedbackMatrixMode = (int) feedbackMatrixValue->load();
+        crossFeed = crossFeedValue->load();
+        feedbackMatrix.setMatrix(feedbackMatrixMode, numDelayChannels, crossFeed);
+    }
+    fdnReverb.setNetwork((int) reverbValue->load());
+    fdnReverb.setSize(reverbSizeValue->load(), crossCount);
+    fdnReverb.setDecay(reverbDecayValue->load());
+    reverbLevelRamp.setTargetValue(reverbLevelValue->load());
+    ducker.setAmount(duckAmountValue->load());
+    ducker.setTimes(duckAttackValue->load(), duckReleaseValue->load());
+    duckSidechain = duckSidechainValue->load() >= 0.5f;
+    delayLfo.setShape((int) lfoShapeValue->load());
+    delayLfo.setRate(lfoRateValue->load());
+    delayLfo.setPhaseOffset(lfoPhaseValue->load() / 360.0f);
+    interpolation = (int) interpolationValue->load();
+    delayMode = (int) delayModeValue->load();
+    if (delayMode == glideMode)
+        for (ReadHead& head : readHeads)
+            head.fading = false;
+    // a delay change held back by a crossfade moves its head once the fade is
+    // over, and starts a fade of its own from there below
+    for (ReadHead& head : readHeads)
+    {
+        if (head.movePending && head.fading == false)
+        {
+            positionForDelay(head.delaySamples, head.position, head.fraction);
+            head.movePending = false;
+        }
+    }
 
-    if (prevDelayReadPosition != delayReadPosition)
-        smoothFlagGlobal = true;
+    // Freezing waits for every crossfade of the read heads to finish, and
+    // thawing for every one of the loop points, so neither cuts a fade short.
+    const bool freeze = freezeValue->load() >= 0.5f;
+    bool headsSettled = true, loopsSettled = true;
+    for (int channel = 0; channel < numDelayChannels; ++channel) {
+        const ReadHead& head = readHeads[channel];
+        headsSettled = headsSettled && head.fading == false && head.prevPosition == head.position && head.prevFraction == head.fraction;
+        loopsSettled = loopsSettled && head.loopFading == false;
+    }
+    if (freeze && frozen == false && (delayMode == glideMode || headsSettled))
+        startFreeze();
+    else if (freeze == false && frozen && loopsSettled)
+        stopFreeze();
 
-    if (smoothValue.size() == 0)
-        for(int i = 0; i<numInputChannels; ++i)
+    // The drive finishes the frames it still owes the line whenever it stops
+    // or gets a new oversampling factor, and starts from the loop whenever it
+    // comes on again. A frozen line is not written, so it doesn't run then.
+    const float newDrive = driveValue->load();
+    const bool driveOn = newDrive > 0.0f && frozen == false;
+    const int oversampling = (int) oversamplingValue->load();
+    const bool newOversampling = oversampling != feedbackDrive.getOversampling();
+    if (driving && (driveOn == false || newOversampling))
+        flushFeedbackDrive();
+    drive = newDrive;
+    if (driveOn && (driving == false || newOversampling))
+    {
+        feedbackDrive.setOversampling(oversampling);
+        primeFeedbackDrive();
+    }
+    driving = driveOn;
+
+    // When a read head has been moved, its old position keeps running as a
+    // second read head into delayBuffer until the crossfade has finished.
+    for (int channel = 0; channel < numDelayChannels; ++channel) {
+        ReadHead& head = readHeads[channel];
+        if (head.fading == false && delayMode == crossfadeMode && frozen == false
+            && (head.prevPosition != head.position || head.prevFraction != head.fraction))
         {
-            smoothValue.push_back(templist);
+            head.fading = true;
+            head.fadeCount = 0;
+            head.crossPosition = head.prevPosition;
+            head.crossFraction = head.prevFraction;
+            // the cross head carries on where the main head's interpolator left off
+            interpolatorState[numDelayChannels + channel] = interpolatorState[channel];
         }
-        
+    }
 
-    // This is the place where you'd normally do the guts of your plugin's
-    // audio processing...
-    for (int channel = 0; channel < numInputChannels; ++channel) {
-        float* channelData = buffer.getWritePointer(channel);
-        float* delayData = delayBuffer.getWritePointer(juce::jmin(channel, delayBuffer.getNumChannels() - 1));
+    // Taps follow the same pattern, each crossfading on its own. Only taps that
+    // can be heard are processed.
+    const int numTaps = (int) numTapsValue->load();
+    numLiveTaps = 0;
+    for (int t = 0; t < maxNumTaps; ++t)
+    {
+        DelayTap& tap = taps[t];
+        // a tap fading in only takes a new time once the fade is over
+        const float newTime = tap.timeValue->load();
+        if (newTime != tap.time && tap.heads.fading == false)
+        {
+            tap.time = newTime;
+            setTapPosition(tap);
+        }
+        tap.gainRamp.setTargetValue(t < numTaps ? tap.gainValue->load() : 0.0f);
+        tap.panRamp.setTargetValue(tap.panValue->load());
+        
+        if (tap.gainRamp.getCurrentValue() == 0.0f && tap.gainRamp.getTargetValue() == 0.0f)
+            continue;
+        liveTaps[numLiveTaps++] = t;
         
-        smoothCount = smoothCurrentCount;
-        smoothWetCount = smoothWetCurrentCount;
-        dpr = delayReadPosition;
-        dpw = delayWritePosition;
-        prevdpr = prevDelayReadPosition;
-        for(int i = 0;i < crossCount; i++)
+        if (tap.heads.fading == false
+            && (tap.prevPosition != tap.heads.position || tap.prevFraction != tap.fraction))
         {
-            smoothValue[channel].push_back(delayData[prevdpr]);
-            prevdpr = (prevdpr+1) % delayBufferLength;
+            tap.heads.fading = true;
+            tap.heads.fadeCount = 0;
+            tap.heads.crossPosition = tap.prevPosition;
+            tap.crossFraction = tap.prevFraction;
+            float* tapState = tapInterpolatorState + t * numInterpolatorStates;
+            juce::FloatVectorOperations::copy(tapState + numDelayChannels, tapState, numDelayChannels);
         }
-        smoothFlag = smoothFlagGlobal;
+    }
 
-        for (int i = 0; i < numSamples; ++i) {
-            const float in = channelData[i];
-            float out = 0.0;
-            
-            out = (dryMix * in + wetMix * delayData[dpr]);
-            if (smoothFlag == true)
+    // The LFO swings the heads back from the longest delay any of them is at,
+    // and never so far that they leave the line.
+    double longestHeadDelay = 0.0, longestDelaySamples = 0.0;
+    bool headsGliding = false;
+    for (int channel = 0; channel < numDelayChannels; ++channel) {
+        const ReadHead& head = readHeads[channel];
+        longestHeadDelay = juce::jmax(longestHeadDelay, head.delaySamples, head.glideDelaySamples);
+        if (head.fading)
+            longestHeadDelay = juce::jmax(longestHeadDelay, distanceToWriteHead(head.crossPosition, delayWritePosition) - (double) head.crossFraction);
+        longestDelaySamples = juce::jmax(longestDelaySamples, head.delaySamples);
+        headsGliding = headsGliding || head.glideDelaySamples != head.delaySamples;
+    }
+    const double maxHeadDelay = (double) (delayBufferLength - DelayInterpolation::numGuardSamples - 1);
+    delayLfo.setDepth((float) (lfoDepthValue->load() * 0.001 * getSampleRate()), (float) (maxHeadDelay - longestHeadDelay));
+
+    // The loop can only be left idle once every crossfade and glide is over,
+    // and never while frozen. The loudest it can hold is the loudest input
+    // since it last went idle, summed over every trip round the loop.
+    bool settled = isAnyHeadFading() == false && headsGliding == false && fdnReverb.isFading() == false && frozen == false;
+    double longestTapSeconds = 0.0;
+    for (int k = 0; k < numLiveTaps; ++k)
+    {
+        settled = settled && taps[liveTaps[k]].heads.fading == false;
+        longestTapSeconds = juce::jmax(longestTapSeconds, (double) taps[liveTaps[k]].time);
+    }
+    if (inputPeak > silenceThreshold)
+    {
+        silentSamples = 0;
+        inputPeakHold = juce::jmax(inputPeakHold, inputPeak);
+        idle = false;
+    }
+    else if (! idle && settled)
+    {
+        const double feedback = juce::jmax(feedbackRamp.getCurrentValue(), feedbackRamp.getTargetValue());
+        const double loopPeak = inputPeakHold / (1.0 - juce::jmin(feedback, 0.9999)) * FeedbackMatrix::getPeakGain(feedbackMatrixMode, numDelayChannels);
+        const double decaySeconds = juce::jmax(getDecaySeconds((longestDelaySamples + delayLfo.getTargetDepth()) / getSampleRate(), feedback, longestTapSeconds, loopPeak),
+                                               FdnReverb::getTailSeconds((int) reverbValue->load(), reverbDecayValue->load(), inputPeakHold, silenceThreshold));
+        idle = silentSamples >= (juce::int64) std::ceil(decaySeconds * getSampleRate());
+        if (idle)
+            inputPeakHold = 0.0f;
+    }
+    if (inputPeak <= silenceThreshold)
+        silentSamples += numSamples;
+
+    if (idle)
+    {
+        // Nothing left in the loop, the output is the dry input. The dry gain
+        // keeps ramping, and every other ramp is moved on with it, so nothing
+        // jumps when the loop starts again.
+        const int numDryChannels = juce::jmin(numInputChannels, buffer.getNumChannels());
+        float* dryData = scratchBuffer.getWritePointer(dryRampScratch);
+        for (int blockStart = 0; blockStart < numSamples; blockStart += maxChunkFrames)
+        {
+            const int blockLength = juce::jmin(numSamples - blockStart, maxChunkFrames);
+            const bool dryMoving = dryMixRamp.render(dryData, blockLength);
+            for (int channel = 0; channel < numDryChannels; ++channel)
             {
-                if(++smoothCount <= crossCount)
-                {
-                    ++smoothWetCount;
-                    float scale = (float) smoothCount/crossCount;
-                    //out = (dryMix * in + wetMix * (scale * delayData[dpr] + (1-scale)*smoothValue[channel]));
-                    out = (dryMix * in + wetMix * (((float)smoothWetCount/crossCount) * scale * delayData[dpr] + (1-scale)*smoothValue[channel][smoothCount]));
-                }
+                if (dryMoving)
+                    juce::FloatVectorOperations::multiply(buffer.getWritePointer(channel, blockStart), dryData, blockLength);
                 else
-                {
-                    smoothCount = 0;
-                    smoothWetCount = 0;
-                    smoothFlag = false;
-                }
-                
+                    buffer.applyGain(channel, blockStart, blockLength, dryMixRamp.getCurrentValue());
+            }
+        }
+        wetMixRamp.skip(numSamples);
+        feedbackRamp.skip(numSamples);
+        reverbLevelRamp.skip(numSamples);
+        for (DelayTap& tap : taps)
+        {
+            tap.gainRamp.skip(numSamples);
+            tap.panRamp.skip(numSamples);
+        }
+    }
+    else
+    {
+        // the interpolator is picked once per block, so each delay loop is specialised for it
+        switch (interpolation) {
+            case DelayInterpolation::linear:
+                processDelayLine<DelayInterpolation::Linear>(buffer);
+                break;
+            case DelayInterpolation::lagrange:
+                processDelayLine<DelayInterpolation::Lagrange>(buffer);
+                break;
+            case DelayInterpolation::allpass:
+                processDelayLine<DelayInterpolation::Allpass>(buffer);
+                break;
+            case DelayInterpolation::hermite:
+            default:
+                processDelayLine<DelayInterpolation::Hermite>(buffer);
+                break;
+        }
+    }
+
+    for (ReadHead& head : readHeads)
+    {
+        if (delayMode == glideMode)
+        {
+            // switching back to crossfade mode fades from wherever the glide got to
+            positionForDelay(head.glideDelaySamples, head.prevPosition, head.prevFraction);
+        }
+        else
+        {
+            head.glideDelaySamples = head.delaySamples;
+            if (head.fading == false)
+            {
+                head.prevPosition = head.position;
+                head.prevFraction = head.fraction;
             }
-            
-            delayData[dpw] = in + (delayData[dpr] * feedback);
-            
-            if (++dpr >= delayBufferLength)
-                dpr = 0;
-            if (++dpw >= delayBufferLength)
-                dpw = 0;
-            
-            channelData[i] = out;
         }
     }
-    smoothValue.clear();
-    smoothFlagGlobal = smoothFlag;
-    smoothCurrentCount = smoothCount;
-    smoothWetCurrentCount = smoothWetCount;
-    delayReadPosition = dpr;
-    delayWritePosition = dpw;
-    if(smoothFlagGlobal == false)
-        prevDelayReadPosition = delayReadPosition;
+    // The recursive states carry over from block to block, where the flags set
+    // above no longer apply, and a host may call us without them. Tiny values
+    // are flushed here, once a block, so none of them can drift into denormals.
+    snapToZero(interpolatorState, numInterpolatorStates);
+    snapToZero(tapInterpolatorState, maxNumTaps * numInterpolatorStates);
+    snapToZero(feedbackFilterState, 2 * numDelayChannels);
+    
+    // an idle block leaves the wet and loop levels at zero
+    MeterFrame meterFrame;
+    meterFrame.input = inputMeter.getLevel();
+    meterFrame.wet = wetMeter.getLevel();
+    meterFrame.loop = loopMeter.getLevel();
+    meterQueue.push(meterFrame);
+    // the view shows the first channel's head
+    const ReadHead& shownHead = readHeads[0];
+    delaySummary.setHeads(delayWritePosition, frozen ? getLoopDelaySamples(shownHead)
+                                                     : delayMode == glideMode ? shownHead.glideDelaySamples : shownHead.delaySamples);
+    
+    // silent taps skip the crossfade and jump straight to their time
+    for (DelayTap& tap : taps)
+    {
+        const bool silent = tap.gainRamp.getCurrentValue() == 0.0f && tap.gainRamp.getTargetValue() == 0.0f;
+        if (silent)
+        {
+            setTapPosition(tap);
+            tap.heads.fading = false;
+        }
+        if (tap.heads.fading == false)
+        {
+            tap.prevPosition = tap.heads.position;
+            tap.prevFraction = tap.fraction;
+        }
+    }
+    
     // In case we have more outputs than inputs, this code clears any output
     // channels that didn't contain input data, (because these aren't
     // guaranteed to be empty - they may contain garbage).
@@ -305,29 +1303,667 @@ void DynamicDelayAudioProcessor::processBlock (juce::AudioSampleBuffer& buffer,
 
 }
 
+// spreads one value per frame over every lane of that frame, in place
+static void expandToLanes (float* data, int numFrames, int numLanes) noexcept
+{
+    for (int j = numFrames; --j >= 0;) {
+        const float value = data[j];
+        for (int lane = numLanes; --lane >= 0;)
+            data[j * numLanes + lane] = value;
+    }
+}
+
+template <typename Interpolator>
+void DynamicDelayAudioProcessor::readLanes (const float* delayData, const int* positions, const float* fractions,
+                                            float* dest, int numFrames, int numLanes, float* state) const
+{
+    // lanes that sit together are read as one, which is every lane unless the channels' delays differ
+    bool together = true;
+    for (int lane = 1; lane < numLanes; ++lane)
+        together = together && positions[lane] == positions[0] && fractions[lane] == fractions[0];
+    if (together)
+    {
+        Interpolator::process (delayData + windowStart (positions[0]) * numLanes, fractions[0], dest, numFrames, numLanes, state);
+        return;
+    }
+
+    int windows[maxNumChannels];
+    for (int lane = 0; lane < numLanes; ++lane)
+        windows[lane] = windowStart (positions[lane]);
+    DelayInterpolation::processLanes<Interpolator> (delayData, windows, fractions, dest, numFrames, numLanes, state);
+}
+
+template <typename Interpolator>
+void DynamicDelayAudioProcessor::readModulated (const float* delayData, const int* positions, const float* fractions, const float* offsets,
+                                                float* dest, int numFrames, int numLanes, float* state) const
+{
+    // one read per sample and lane, each offset on its own behind its head at positions[lane] + fractions[lane]
+    for (int j = 0; j < numFrames; ++j) {
+        for (int lane = 0; lane < numLanes; ++lane) {
+            double exactPosition = positions[lane] + j + (double) fractions[lane] - offsets[j * numLanes + lane];
+            if (exactPosition < 0)
+                exactPosition += delayBufferLength;
+            else if (exactPosition >= delayBufferLength)
+                exactPosition -= delayBufferLength;
+            const int p = (int) exactPosition;
+            const float* window = delayData + windowStart (p) * numLanes;
+            dest[j * numLanes + lane] = Interpolator::interpolate (window + lane, numLanes, (float) (exactPosition - p), state[lane]);
+        }
+    }
+}
+
+template <typename Interpolator>
+void DynamicDelayAudioProcessor::processDelayLine (juce::AudioSampleBuffer& buffer)
+{
+    // every input channel has its own line or lane, unless the host changed the layout without preparing again
+    const int numChannels = juce::jmin(getMainBusNumInputChannels(), buffer.getNumChannels(), numDelayChannels);
+    const int numSamples = buffer.getNumSamples();
+    // A planar store runs a pass per channel over that channel's line. An
+    // interleaved one runs a single pass with every channel as a lane of each
+    // frame, so positions and segments below are in frames of numLanes floats.
+    const int numLanes = numDelayLanes;
+    const int numPasses = numDelayLines;
+    // the driven samples are written back this many frames behind the write head
+    const int driveLatency = driving ? feedbackDrive.getLatency() : 0;
+
+    // Blocks bigger than announced in prepareToPlay are processed in chunks
+    // that fit the scratch buffer. The feedback matrix mixes a chunk's
+    // feedback once every line has been read, so then no chunk may read what
+    // it writes either. A frozen line is not written at all.
+    const bool mixing = feedbackMatrix.isActive() && ! frozen;
+    for (int blockStart = 0; blockStart < numSamples;) {
+        int blockLength = juce::jmin (numSamples - blockStart, maxChunkFrames);
+        if (mixing)
+            blockLength = juce::jmin (blockLength, framesBeforeUnmixedReads (driveLatency));
+        const int chunkWritePosition = delayWritePosition;
+
+        // gains are rendered once per chunk, nullptr means the value is steady
+        float* dryData = scratchBuffer.getWritePointer (dryRampScratch);
+        float* wetRampData = scratchBuffer.getWritePointer (wetRampScratch);
+        float* feedbackData = scratchBuffer.getWritePointer (feedbackRampScratch);
+        const float* dryGain = dryMixRamp.render (dryData, blockLength) ? dryData : nullptr;
+        const float* wetGain = wetMixRamp.render (wetRampData, blockLength) ? wetRampData : nullptr;
+        const float* feedbackGain = feedbackRamp.render (feedbackData, blockLength) ? feedbackData : nullptr;
+        const float dry = dryMixRamp.getCurrentValue();
+        const float wet = wetMixRamp.getCurrentValue();
+        const float fb = feedbackRamp.getCurrentValue();
+
+        // Tap gains per side of a channel pair, balance panned. A moving gain or
+        // pan is rendered into tapGainBuffer, left in channel 2t and right in 2t + 1.
+        bool tapMoving[maxNumTaps];
+        float tapLeft[maxNumTaps], tapRight[maxNumTaps];
+        for (int k = 0; k < numLiveTaps; ++k) {
+            const int t = liveTaps[k];
+            DelayTap& tap = taps[t];
+            float* leftData = tapGainBuffer.getWritePointer (2 * t);
+            float* rightData = tapGainBuffer.getWritePointer (2 * t + 1);
+            const bool gainMoving = tap.gainRamp.render (leftData, blockLength);
+            const bool panMoving = tap.panRamp.render (rightData, blockLength);
+            tapMoving[t] = gainMoving || panMoving;
+            const float g = tap.gainRamp.getCurrentValue();
+            const float p = numChannels > 1 ? tap.panRamp.getCurrentValue() : 0.0f;
+            tapLeft[t] = g * juce::jmin (1.0f, 1.0f - p);
+            tapRight[t] = g * juce::jmin (1.0f, 1.0f + p);
+            if (tapMoving[t])
+            {
+                if (! gainMoving)
+                    juce::FloatVectorOperations::fill (leftData, g, blockLength);
+                if (! panMoving || numChannels == 1)
+                    juce::FloatVectorOperations::fill (rightData, p, blockLength);
+                for (int j = 0; j < blockLength; ++j) {
+                    const float gain = leftData[j], pan = rightData[j];
+                    leftData[j] = gain * juce::jmin (1.0f, 1.0f - pan);
+                    rightData[j] = gain * juce::jmin (1.0f, 1.0f + pan);
+                }
+            }
+        }
+
+        // The ducking follows the input, or the sidechain, and turns the wet gain
+        // down sample by sample. The key is read before any pass writes the output.
+        const float* duckGain = nullptr;
+        if (ducker.isActive())
+        {
+            const float* key[maxNumChannels];
+            int numKeyChannels = 0;
+            const int mainChannels = getMainBusNumInputChannels();
+            const int sidechainChannels = juce::jmin (getTotalNumInputChannels(), buffer.getNumChannels()) - mainChannels;
+            if (duckSidechain && sidechainChannels > 0)
+            {
+                for (int channel = 0; channel < juce::jmin (sidechainChannels, (int) maxNumChannels); ++channel)
+                    key[numKeyChannels++] = buffer.getReadPointer (mainChannels + channel, blockStart);
+            }
+            else
+            {
+                for (int channel = 0; channel < numChannels; ++channel)
+                    key[numKeyChannels++] = buffer.getReadPointer (channel, blockStart);
+            }
+
+            float* duckData = scratchBuffer.getWritePointer (duckGainScratch);
+            ducker.process (key, numKeyChannels, duckData, blockLength);
+            if (wetGain == nullptr)
+                juce::FloatVectorOperations::fill (wetRampData, wet, blockLength);
+            juce::FloatVectorOperations::multiply (wetRampData, duckData, blockLength);
+            wetGain = wetRampData;
+            duckGain = duckData;
+        }
+
+        float* interleavedData = scratchBuffer.getWritePointer (interleavedScratch);
+        if (numLanes > 1)
+        {
+            if (dryGain != nullptr)
+                expandToLanes (dryData, blockLength, numLanes);
+            if (wetGain != nullptr)
+                expandToLanes (wetRampData, blockLength, numLanes);
+            if (feedbackGain != nullptr)
+                expandToLanes (feedbackData, blockLength, numLanes);
+
+            for (int lane = 0; lane < numLanes; ++lane) {
+                const float* channelData = lane < numChannels ? buffer.getReadPointer (lane, blockStart) : nullptr;
+                for (int j = 0; j < blockLength; ++j)
+                    interleavedData[j * numLanes + lane] = channelData != nullptr ? channelData[j] : 0.0f;
+            }
+        }
+
+        // A ping-pong takes the input into the loop as a mono sum on the first
+        // channel, whose feedback the matrix hands on to the next. The other
+        // channels only get their feedback.
+        const float* monoInput = nullptr;
+        const float* silentInput = nullptr;
+        if (feedbackMatrix.takesMonoInput())
+        {
+            float* monoData = scratchBuffer.getWritePointer (loopInputScratch);
+            float* silentData = scratchBuffer.getWritePointer (silentInputScratch);
+            const float scale = 1.0f / (float) numChannels;
+            if (numLanes > 1)
+            {
+                juce::FloatVectorOperations::clear (monoData, blockLength * numLanes);
+                for (int j = 0; j < blockLength; ++j) {
+                    float sum = 0.0f;
+                    for (int lane = 0; lane < numChannels; ++lane)
+                        sum += interleavedData[j * numLanes + lane];
+                    monoData[j * numLanes] = sum * scale;
+                }
+            }
+            else
+            {
+                juce::FloatVectorOperations::copy (monoData, buffer.getReadPointer (0, blockStart), blockLength);
+                for (int channel = 1; channel < numChannels; ++channel)
+                    juce::FloatVectorOperations::add (monoData, buffer.getReadPointer (channel, blockStart), blockLength);
+                juce::FloatVectorOperations::multiply (monoData, scale, blockLength);
+                juce::FloatVectorOperations::clear (silentData, blockLength);
+            }
+            monoInput = monoData;
+            silentInput = silentData;
+        }
+
+        // The reverb hears the same input as the delay, summed to mono, before
+        // the passes below turn the buffer into the output.
+        if (fdnReverb.isActive())
+        {
+            float* reverbInput = scratchBuffer.getWritePointer (reverbInputScratch);
+            const float scale = 1.0f / (float) numChannels;
+            if (numLanes > 1)
+            {
+                for (int j = 0; j < blockLength; ++j) {
+                    float sum = 0.0f;
+                    for (int lane = 0; lane < numChannels; ++lane)
+                        sum += interleavedData[j * numLanes + lane];
+                    reverbInput[j] = sum;
+                }
+            }
+            else
+            {
+                juce::FloatVectorOperations::copy (reverbInput, buffer.getReadPointer (0, blockStart), blockLength);
+                for (int channel = 1; channel < numChannels; ++channel)
+                    juce::FloatVectorOperations::add (reverbInput, buffer.getReadPointer (channel, blockStart), blockLength);
+            }
+            juce::FloatVectorOperations::multiply (reverbInput, scale, blockLength);
+            fdnReverb.process (reverbInput, blockLength);
+        }
+
+        int dpw = delayWritePosition;
+        DelayTap::Heads tapHeads[maxNumTaps];
+
+        // This is the place where you'd normally do the guts of your plugin's
+        // audio processing...
+        for (int pass = 0; pass < juce::jmin (numPasses, numChannels); ++pass) {
+            float* channelData = numLanes > 1 ? interleavedData : buffer.getWritePointer(pass, blockStart);
+            float* delayData = delayBuffer->getWritePointer(pass);
+            float* readState = interpolatorState + pass;
+            float* lowCutState = feedbackFilterState + pass;
+            float* highCutState = lowCutState + numDelayChannels;
+            float* crossState = readState + numDelayChannels;
+            // every pass has read heads of its own, one per lane, and moves them on itself
+            ReadHead* heads = readHeads + pass * numLanes;
+            int positions[maxNumChannels], crossPositions[maxNumChannels];
+            float fractions[maxNumChannels], crossFractions[maxNumChannels];
+            int fadeCounts[maxNumChannels], fadeLengths[maxNumChannels];
+            const float* loopInput = monoInput;
+            if (monoInput != nullptr && numLanes == 1 && pass != 0)
+                loopInput = silentInput;
+            // the LFO's offsets for this pass's channels, for the whole chunk
+            float* lfoData = nullptr;
+            if (delayLfo.isActive() && ! frozen)
+            {
+                lfoData = scratchBuffer.getWritePointer (lfoOffsetScratch);
+                delayLfo.render (lfoData, blockLength, pass, numLanes);
+            }
+            
+            dpw = delayWritePosition;
+            for (int k = 0; k < numLiveTaps; ++k)
+                tapHeads[liveTaps[k]] = taps[liveTaps[k]].heads;
+
+            // Frozen, the line is only read, by the loop heads. Nothing is
+            // written, so there is no feedback, and the taps are left out.
+            if (frozen)
+            {
+                for (int i = 0; i < blockLength;) {
+                    // segments where no window wraps and no lane passes a loop point
+                    int n = blockLength - i;
+                    bool loopFlag = false;
+                    for (int lane = 0; lane < numLanes; ++lane) {
+                        ReadHead& head = heads[lane];
+                        int toJump = (loopEnd - head.loopFade - head.loopPosition + 2 * delayBufferLength) % delayBufferLength;
+                        if (head.loopFading == false && toJump == 0)
+                        {
+                            // the loop head goes back a loop length, the old position carries on fading out
+                            head.loopCrossPosition = head.loopPosition;
+                            head.loopPosition = head.loopPosition >= head.loopLength ? head.loopPosition - head.loopLength
+                                                                                     : head.loopPosition - head.loopLength + delayBufferLength;
+                            head.loopFading = head.loopFade > 0;
+                            head.loopFadeCount = 0;
+                            toJump = head.loopLength;
+                            crossState[lane] = readState[lane];
+                        }
+
+                        n = juce::jmin (n, delayBufferLength - windowStart (head.loopPosition));
+                        if (head.loopFading)
+                            n = juce::jmin (n, head.loopFade - head.loopFadeCount, delayBufferLength - windowStart (head.loopCrossPosition));
+                        else
+                            n = juce::jmin (n, toJump);
+                        loopFlag = loopFlag || head.loopFading;
+
+                        positions[lane] = head.loopPosition;
+                        fractions[lane] = head.loopFraction;
+                        // a lane that isn't fading reads its own position again, and doesn't hear it
+                        crossPositions[lane] = head.loopFading ? head.loopCrossPosition : head.loopPosition;
+                        fadeCounts[lane] = head.loopFading ? head.loopFadeCount : 1;
+                        fadeLengths[lane] = head.loopFading ? head.loopFade : 1;
+                    }
+                    const int count = n * numLanes;
+
+                    float* in = channelData + i * numLanes;
+                    float* readData = scratchBuffer.getWritePointer (readScratch);
+                    const float* wetData = readData;
+                    readLanes<Interpolator> (delayData, positions, fractions, readData, n, numLanes, readState);
+                    if (loopFlag)
+                    {
+                        float* fadeData = scratchBuffer.getWritePointer (fadeScratch);
+                        float* crossData = scratchBuffer.getWritePointer (crossReadScratch);
+                        float* newGain = scratchBuffer.getWritePointer (newGainScratch);
+                        float* oldGain = scratchBuffer.getWritePointer (oldGainScratch);
+                        Crossfade::renderLaneGains (newGain, oldGain, fadeCounts, fadeLengths, n, numLanes);
+                        readLanes<Interpolator> (delayData, crossPositions, fractions, crossData, n, numLanes, crossState);
+                        juce::FloatVectorOperations::multiply (fadeData, readData, newGain, count);
+                        juce::FloatVectorOperations::addWithMultiply (fadeData, crossData, oldGain, count);
+                        wetData = fadeData;
+                        for (int lane = 0; lane < numLanes; ++lane) {
+                            ReadHead& head = heads[lane];
+                            if (head.loopFading)
+                            {
+                                head.loopFadeCount += n;
+                                if (head.loopFadeCount >= head.loopFade)
+                                    head.loopFading = false;
+                            }
+                        }
+                    }
+                    wetMeter.add (wetData, count);
+
+                    // out = dryMix * in + wetMix * delayed
+                    if (dryGain != nullptr)
+                        juce::FloatVectorOperations::multiply (in, dryGain + i * numLanes, count);
+                    else
+                        juce::FloatVectorOperations::multiply (in, dry, count);
+                    if (wetGain != nullptr)
+                        juce::FloatVectorOperations::addWithMultiply (in, wetData, wetGain + i * numLanes, count);
+                    else
+                        juce::FloatVectorOperations::addWithMultiply (in, wetData, wet, count);
+
+                    for (int lane = 0; lane < numLanes; ++lane) {
+                        heads[lane].loopPosition = wrapPosition (heads[lane].loopPosition + n);
+                        heads[lane].loopCrossPosition = wrapPosition (heads[lane].loopCrossPosition + n);
+                    }
+                    i += n;
+                }
+                continue;
+            }
+
+            for (int i = 0; i < blockLength;) {
+                // Split the block into segments where no interpolation window or
+                // the write head wraps, and no sample is read after being written
+                // in the same segment, so each segment can run as whole-vector
+                // operations. The guard samples past the end of delayBuffer
+                // mirror its start, so a window may run over the end. Driven
+                // samples are only final once the drive has written them back
+                // at dpd, so no window may reach that either. Undriven, dpd is dpw.
+                const int dpd = dpw >= driveLatency ? dpw - driveLatency : dpw - driveLatency + delayBufferLength;
+                int n = juce::jmin (blockLength - i, delayBufferLength - dpw, delayBufferLength - dpd);
+                // the longest any lane of this pass has still to fade
+                int numFading = 0;
+                for (int lane = 0; lane < numLanes; ++lane) {
+                    const ReadHead& head = heads[lane];
+                    if (delayMode == glideMode)
+                    {
+                        // the glide never passes its target, so no window reaches
+                        // this segment's writes while n stays below the shortest delay
+                        const double shortestDelay = juce::jmin (head.glideDelaySamples, head.delaySamples);
+                        n = juce::jmin (n, juce::jmax (1, (int) shortestDelay - driveLatency - DelayInterpolation::numGuardSamples + 1));
+                    }
+                    else
+                    {
+                        const int readWindow = windowStart (head.position);
+                        n = juce::jmin (n, delayBufferLength - readWindow);
+                        n = juce::jmin (n, distanceToWriteHead (wrapPosition (readWindow + DelayInterpolation::numGuardSamples), dpd));
+                    }
+                    if (head.fading)
+                    {
+                        const int crossWindow = windowStart (head.crossPosition);
+                        n = juce::jmin (n, delayBufferLength - crossWindow,
+                                        distanceToWriteHead (wrapPosition (crossWindow + DelayInterpolation::numGuardSamples), dpd));
+                        numFading = juce::jmax (numFading, crossCount - head.fadeCount);
+                    }
+                    positions[lane] = head.position;
+                    fractions[lane] = head.fraction;
+                    // a lane that isn't fading reads its own position again, and doesn't hear it
+                    crossPositions[lane] = head.fading ? head.crossPosition : head.position;
+                    crossFractions[lane] = head.fading ? head.crossFraction : head.fraction;
+                    fadeCounts[lane] = head.fading ? head.fadeCount : crossCount;
+                    fadeLengths[lane] = crossCount;
+                }
+                for (int k = 0; k < numLiveTaps; ++k) {
+                    const DelayTap::Heads& heads = tapHeads[liveTaps[k]];
+                    const int tapWindow = windowStart (heads.position);
+                    n = juce::jmin (n, delayBufferLength - tapWindow,
+                                    distanceToWriteHead (wrapPosition (tapWindow + DelayInterpolation::numGuardSamples), dpd));
+                    if (heads.fading)
+                    {
+                        const int tapCrossWindow = windowStart (heads.crossPosition);
+                        n = juce::jmin (n, delayBufferLength - tapCrossWindow,
+                                        distanceToWriteHead (wrapPosition (tapCrossWindow + DelayInterpolation::numGuardSamples), dpd));
+                    }
+                }
+                const int count = n * numLanes;
+
+                float* in = channelData + i * numLanes;
+                float* readData = scratchBuffer.getWritePointer (readScratch);
+                const float* wetData = readData;
+                if (delayMode == glideMode)
+                {
+                    // one read per sample at a moving position, like a tape head changing speed
+                    for (int lane = 0; lane < numLanes; ++lane) {
+                        ReadHead& head = heads[lane];
+                        double glideDelay = head.glideDelaySamples;
+                        for (int j = 0; j < n; ++j) {
+                            if (glideDelay < head.delaySamples)
+                                glideDelay = juce::jmin (head.delaySamples, glideDelay + head.glideStep);
+                            else if (glideDelay > head.delaySamples)
+                                glideDelay = juce::jmax (head.delaySamples, glideDelay - head.glideStep);
+
+                            double position = dpw + j - glideDelay;
+                            if (lfoData != nullptr)
+                                position -= lfoData[(i + j) * numLanes + lane];
+                            if (position < 0)
+                                position += delayBufferLength;
+                            const int p = (int) position;
+                            const float* window = delayData + windowStart (p) * numLanes;
+                            readData[j * numLanes + lane] = Interpolator::interpolate (window + lane, numLanes, (float) (position - p), readState[lane]);
+                        }
+                        head.glideDelaySamples = glideDelay;
+                    }
+                }
+                else if (lfoData != nullptr)
+                {
+                    readModulated<Interpolator> (delayData, positions, fractions, lfoData + i * numLanes, readData, n, numLanes, readState);
+                }
+                else
+                {
+                    readLanes<Interpolator> (delayData, positions, fractions, readData, n, numLanes, readState);
+                }
+
+                numFading = juce::jmin (n, numFading);
+                if (numFading > 0)
+                {
+                    float* fadeData = scratchBuffer.getWritePointer (fadeScratch);
+                    float* crossData = scratchBuffer.getWritePointer (crossReadScratch);
+                    float* newGain = scratchBuffer.getWritePointer (newGainScratch);
+                    float* oldGain = scratchBuffer.getWritePointer (oldGainScratch);
+                    Crossfade::renderLaneGains (newGain, oldGain, fadeCounts, fadeLengths, numFading, numLanes);
+                    const int fadeCount = numFading * numLanes;
+                    if (lfoData != nullptr)
+                        readModulated<Interpolator> (delayData, crossPositions, crossFractions, lfoData + i * numLanes, crossData, numFading, numLanes, crossState);
+                    else
+                        readLanes<Interpolator> (delayData, crossPositions, crossFractions, crossData, numFading, numLanes, crossState);
+                    juce::FloatVectorOperations::multiply (fadeData, readData, newGain, fadeCount);
+                    juce::FloatVectorOperations::addWithMultiply (fadeData, crossData, oldGain, fadeCount);
+                    juce::FloatVectorOperations::copy (fadeData + fadeCount, readData + fadeCount, count - fadeCount);
+                    wetData = fadeData;
+                }
+                // a fade also ends here when the cross time was cut short under it
+                for (int lane = 0; lane < numLanes; ++lane) {
+                    ReadHead& head = heads[lane];
+                    if (head.fading)
+                    {
+                        head.fadeCount += juce::jlimit (0, n, crossCount - head.fadeCount);
+                        if (head.fadeCount >= crossCount)
+                        {
+                            head.fadeCount = 0;
+                            head.fading = false;
+                        }
+                    }
+                }
+
+                // The taps are gathered into the wet signal before this segment's
+                // write, since a long tap reads the samples it overwrites.
+                if (numLiveTaps > 0)
+                {
+                    float* mixData = scratchBuffer.getWritePointer (tapMixScratch);
+                    float* tapData = scratchBuffer.getWritePointer (tapReadScratch);
+                    juce::FloatVectorOperations::copy (mixData, wetData, count);
+                    for (int k = 0; k < numLiveTaps; ++k) {
+                        const int t = liveTaps[k];
+                        DelayTap& tap = taps[t];
+                        DelayTap::Heads& heads = tapHeads[t];
+                        float* tapState = tapInterpolatorState + t * numInterpolatorStates + pass;
+                        Interpolator::process (delayData + windowStart (heads.position) * numLanes, tap.fraction, tapData, n, numLanes, tapState);
+                        if (heads.fading)
+                        {
+                            const int numFading = juce::jmin (n, crossCount - heads.fadeCount);
+                            float* crossData = scratchBuffer.getWritePointer (crossReadScratch);
+                            float* newGain = scratchBuffer.getWritePointer (newGainScratch);
+                            float* oldGain = scratchBuffer.getWritePointer (oldGainScratch);
+                            Crossfade::renderGains (newGain, oldGain, heads.fadeCount, crossCount, numFading, numLanes);
+                            const int fadeCount = numFading * numLanes;
+                            Interpolator::process (delayData + windowStart (heads.crossPosition) * numLanes, tap.crossFraction, crossData,
+                                                   numFading, numLanes, tapState + numDelayChannels);
+                            juce::FloatVectorOperations::multiply (tapData, newGain, fadeCount);
+                            juce::FloatVectorOperations::addWithMultiply (tapData, crossData, oldGain, fadeCount);
+                            heads.fadeCount += numFading;
+                            if (heads.fadeCount >= crossCount)
+                            {
+                                heads.fadeCount = 0;
+                                heads.fading = false;
+                            }
+                        }
+
+                        // even channels take the left gain, odd ones the right
+                        if (numLanes > 1)
+                        {
+                            for (int lane = 0; lane < numLanes; ++lane) {
+                                const float* gain = tapGainBuffer.getReadPointer (2 * t + (lane & 1), i);
+                                const float steady = (lane & 1) != 0 ? tapRight[t] : tapLeft[t];
+                                for (int j = 0; j < n; ++j)
+                                    mixData[j * numLanes + lane] += tapData[j * numLanes + lane] * (tapMoving[t] ? gain[j] : steady);
+                            }
+                        }
+                        else if (tapMoving[t])
+                            juce::FloatVectorOperations::addWithMultiply (mixData, tapData, tapGainBuffer.getReadPointer (2 * t + (pass & 1), i), n);
+                        else
+                            juce::FloatVectorOperations::addWithMultiply (mixData, tapData, (pass & 1) != 0 ? tapRight[t] : tapLeft[t], n);
+                        heads.position = wrapPosition (heads.position + n);
+                        heads.crossPosition = wrapPosition (heads.crossPosition + n);
+                    }
+                    wetData = mixData;
+                }
+                wetMeter.add (wetData, count);
+
+                // delayData[dpw] = in + read * feedback
+                float* writeData = delayData + dpw * numLanes;
+                const float* loopIn = loopInput != nullptr ? loopInput + i * numLanes : in;
+                const bool shaping = feedbackFilter.isActive() || saturation > 0.0f || driving || mixing;
+                float* loopData = nullptr;
+                if (shaping)
+                {
+                    // The loop's tone shaping runs over the whole segment. The
+                    // input is written on its own, the feedback is added to it
+                    // by addFeedback(), which runs the drive, or at the end of
+                    // the chunk once the matrix has mixed it, so neither the
+                    // drive nor the matrix ever get the input.
+                    loopData = mixing ? feedbackBuffer.getWritePointer (pass, i * numLanes)
+                                      : scratchBuffer.getWritePointer (feedbackLoopScratch);
+                    feedbackFilter.process (readData, loopData, n, numLanes, lowCutState, highCutState);
+                    if (feedbackGain != nullptr)
+                        juce::FloatVectorOperations::multiply (loopData, feedbackGain + i * numLanes, count);
+                    else
+                        juce::FloatVectorOperations::multiply (loopData, fb, count);
+                    if (saturation > 0.0f)
+                        FeedbackFilter::saturate (loopData, scratchBuffer.getWritePointer (saturationScratch), count, saturation);
+                    juce::FloatVectorOperations::copy (writeData, loopIn, count);
+                }
+                else
+                {
+                    juce::FloatVectorOperations::copy (writeData, loopIn, count);
+                    if (feedbackGain != nullptr)
+                        juce::FloatVectorOperations::addWithMultiply (writeData, readData, feedbackGain + i * numLanes, count);
+                    else
+                        juce::FloatVectorOperations::addWithMultiply (writeData, readData, fb, count);
+                }
+                if (dpw < DelayInterpolation::numGuardSamples)
+                    juce::FloatVectorOperations::copy (delayData + (delayBufferLength + dpw) * numLanes, writeData,
+                                                       juce::jmin (n, DelayInterpolation::numGuardSamples - dpw) * numLanes);
+                if (! shaping)
+                {
+                    loopMeter.add (writeData, count);
+                    delaySummary.add (writeData, dpw, n, numLanes, pass == 0);
+                }
+                else if (! mixing)
+                {
+                    addFeedback (pass, loopData, dpw, n);
+                }
+
+                // out = dryMix * in + wetMix * delayed
+                if (dryGain != nullptr)
+                    juce::FloatVectorOperations::multiply (in, dryGain + i * numLanes, count);
+                else
+                    juce::FloatVectorOperations::multiply (in, dry, count);
+                if (wetGain != nullptr)
+                    juce::FloatVectorOperations::addWithMultiply (in, wetData, wetGain + i * numLanes, count);
+                else
+                    juce::FloatVectorOperations::addWithMultiply (in, wetData, wet, count);
+
+                for (int lane = 0; lane < numLanes; ++lane) {
+                    heads[lane].position = wrapPosition (heads[lane].position + n);
+                    heads[lane].crossPosition = wrapPosition (heads[lane].crossPosition + n);
+                }
+                dpw = wrapPosition (dpw + n);
+                i += n;
+            }
+        }
+
+        if (fdnReverb.isActive())
+        {
+            float* levelData = scratchBuffer.getWritePointer (reverbLevelScratch);
+            bool levelMoving = reverbLevelRamp.render (levelData, blockLength);
+            const float level = reverbLevelRamp.getCurrentValue();
+            // the reverb ducks with the delay
+            if (duckGain != nullptr)
+            {
+                if (! levelMoving)
+                    juce::FloatVectorOperations::fill (levelData, level, blockLength);
+                juce::FloatVectorOperations::multiply (levelData, duckGain, blockLength);
+                levelMoving = true;
+            }
+            for (int channel = 0; channel < numChannels; ++channel) {
+                const float* reverbData = fdnReverb.getOutput (channel);
+                if (numLanes > 1)
+                {
+                    for (int j = 0; j < blockLength; ++j)
+                        interleavedData[j * numLanes + channel] += reverbData[j] * (levelMoving ? levelData[j] : level);
+                }
+                else if (levelMoving)
+                {
+                    juce::FloatVectorOperations::addWithMultiply (buffer.getWritePointer (channel, blockStart), reverbData, levelData, blockLength);
+                }
+                else
+                {
+                    juce::FloatVectorOperations::addWithMultiply (buffer.getWritePointer (channel, blockStart), reverbData, level, blockLength);
+                }
+            }
+        }
+
+        if (numLanes > 1)
+        {
+            for (int channel = 0; channel < numChannels; ++channel) {
+                float* channelData = buffer.getWritePointer (channel, blockStart);
+                for (int j = 0; j < blockLength; ++j)
+                    channelData[j] = interleavedData[j * numLanes + channel];
+            }
+        }
+
+        delayWritePosition = dpw;
+        for (int k = 0; k < numLiveTaps; ++k)
+            taps[liveTaps[k]].heads = tapHeads[liveTaps[k]];
+        if (delayLfo.isActive())
+            delayLfo.advance (blockLength);
+        if (mixing)
+            mixFeedback (chunkWritePosition, blockLength);
+        blockStart += blockLength;
+    }
+}
+
 //==============================================================================
 bool DynamicDelayAudioProcessor::hasEditor() const
 {
+   #if DYNAMICDELAY_HEADLESS
+    return false; // the DSP-only library is built without the editor
+   #else
     return true; // (change this to false if you choose to not supply an editor)
+   #endif
 }
 
 juce::AudioProcessorEditor* DynamicDelayAudioProcessor::createEditor()
 {
+   #if DYNAMICDELAY_HEADLESS
+    return nullptr;
+   #else
     return new DynamicDelayAudioProcessorEditor (*this);
+   #endif
 }
 
 //==============================================================================
 void DynamicDelayAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
 {
-    // You should use this method to store your parameters in the memory block.
-    // You could do that either as raw data, or use the XML or ValueTree classes
-    // as intermediaries to make it easy to save and load complex data.
+    // The parameter tree is stored in ValueTree's binary format, which is
+    // smaller and much quicker to parse than XML when a session loads.
+    juce::MemoryOutputStream stream (destData, false);
+    parameters.copyState().writeToStream (stream);
 }
 
 void DynamicDelayAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
-    // You should use this method to restore your parameters from this memory block,
-    // whose contents will have been created by the getStateInformation() call.
+    const juce::ValueTree state = juce::ValueTree::readFromData (data, (size_t) sizeInBytes);
+
+    if (state.isValid() && state.hasType (parameters.state.getType()))
+        parameters.replaceState (state);
 }
 
 //==============================================================================
@@ -11,7 +11,18 @@
 #pragma once
 
 #include <JuceHeader.h>
-#include <vector>
+#include "ParameterRamp.h"
+#include "DelayInterpolation.h"
+#include "Crossfade.h"
+#include "DelayBufferAllocator.h"
+#include "FeedbackFilter.h"
+#include "FeedbackDrive.h"
+#include "FeedbackMatrix.h"
+#include "FdnReverb.h"
+#include "Ducker.h"
+#include "DelayLfo.h"
+#include "MeterQueue.h"
+#include "DelaySummary.h"
 
 //==============================================================================
 /*
@@ -35,18 +46,13 @@ public:
     //==============================================================================
     const juce::String getName() const override;
 
-    int getNumParameters() override;
-    float getParameter (int index) override;
-    void setParameter (int index, float newValue) override;
-
-    const juce::String getParameterName (int index) override;
-    const juce::String getParameterText (int index) override;
-
     const juce::String getInputChannelName (int channelIndex) const override;
     const juce::String getOutputChannelName (int channelIndex) const override;
     bool isInputChannelStereoPair (int index) const override;
     bool isOutputChannelStereoPair (int index) const override;
 
+    bool isBusesLayoutSupported (const BusesLayout& layouts) const override;
+    
     bool acceptsMidi() const override;
     bool producesMidi() const override;
     bool silenceInProducesSilenceOut() const override;
@@ -66,6 +72,17 @@ public:
     //==============================================================================
     int lastUIWidth, lastUIHeight;
     
+    // extra read heads over the same delay line, mixed into the wet signal
+    static constexpr int maxNumTaps = 16;
+    
+    enum TapParameters
+    {
+        tapTimeParam = 0,
+        tapGainParam,
+        tapPanParam,
+        numTapParameters
+    };
+    
     enum Parameters
     {
         delayLengthParam = 0,
@@ -73,27 +90,339 @@ public:
         wetMixParam,
         feedbackParam,
         crossLengthParam,
-        numParameters
+        interpolationParam,
+        delayModeParam,
+        maxDelayParam,
+        numTapsParam,
+        syncParam,
+        divisionParam,
+        lowCutParam,
+        highCutParam,
+        saturationParam,
+        driveParam,
+        oversamplingParam,
+        feedbackMatrixParam,
+        crossFeedParam,
+        reverbParam,
+        reverbSizeParam,
+        reverbDecayParam,
+        reverbLevelParam,
+        duckAmountParam,
+        duckAttackParam,
+        duckReleaseParam,
+        duckSidechainParam,
+        lfoShapeParam,
+        lfoRateParam,
+        lfoDepthParam,
+        lfoPhaseParam,
+        freezeParam,
+        rightOffsetParam,
+        firstTapParam,
+        numParameters = firstTapParam + maxNumTaps * numTapParameters
     };
     
-    float delayLength;
-    float dryMix;
-    float wetMix;
-    float feedback;
-    float crossLength;
+    enum DelayModes
+    {
+        crossfadeMode = 0,  // a second read head fades out from the old delay time
+        glideMode           // the read head glides to the new delay time, bending the pitch
+    };
+    
+    static const char* getParameterID (int index);
+    static int getTapParameterIndex (int tap, int tapParameter)     { return firstTapParam + tap * numTapParameters + tapParameter; }
+    static juce::StringArray getDelayModeNames();
+    static juce::StringArray getDivisionNames();
+    
+    // Stores the delay channel-interleaved, so one pass handles every channel of
+    // a frame, instead of one line per channel. Takes effect at the next
+    // prepareToPlay, hosts never see it.
+    void setInterleavedDelayStore (bool shouldInterleave) noexcept     { interleavedDelayStore = shouldInterleave; }
+    bool isInterleavedDelayStore() const noexcept                       { return interleavedDelayStore; }
+    
+    juce::AudioProcessorValueTreeState parameters;
+    
+    // a frame of levels per block, for the editor to drain
+    MeterQueue meterQueue;
+    
+    // min and max of the delay line and where its heads are, for the editor to draw
+    DelaySummary delaySummary;
 
 private:
-    // circular buffer variables
-    juce::AudioSampleBuffer delayBuffer;
+    static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
+    
+    // the longest delay that can be configured, 60 s at 192 kHz is about 11.5M samples per channel
+    static constexpr float maxDelaySeconds = 60.0f;
+    
+    // mono up to 7.1.4 and 16 channel beds, every channel gets its own delay line
+    static constexpr int maxNumChannels = 16;
+    
+    // raw parameter values, written by the host or editor and read on the audio thread
+    std::atomic<float>* delayLengthValue;
+    std::atomic<float>* dryMixValue;
+    std::atomic<float>* wetMixValue;
+    std::atomic<float>* feedbackValue;
+    std::atomic<float>* crossLengthValue;
+    std::atomic<float>* interpolationValue;
+    std::atomic<float>* delayModeValue;
+    std::atomic<float>* maxDelayValue;
+    std::atomic<float>* numTapsValue;
+    std::atomic<float>* syncValue;
+    std::atomic<float>* divisionValue;
+    std::atomic<float>* lowCutValue;
+    std::atomic<float>* highCutValue;
+    std::atomic<float>* saturationValue;
+    std::atomic<float>* driveValue;
+    std::atomic<float>* oversamplingValue;
+    std::atomic<float>* feedbackMatrixValue;
+    std::atomic<float>* crossFeedValue;
+    std::atomic<float>* reverbValue;
+    std::atomic<float>* reverbSizeValue;
+    std::atomic<float>* reverbDecayValue;
+    std::atomic<float>* reverbLevelValue;
+    std::atomic<float>* duckAmountValue;
+    std::atomic<float>* duckAttackValue;
+    std::atomic<float>* duckReleaseValue;
+    std::atomic<float>* duckSidechainValue;
+    std::atomic<float>* lfoShapeValue;
+    std::atomic<float>* lfoRateValue;
+    std::atomic<float>* lfoDepthValue;
+    std::atomic<float>* lfoPhaseValue;
+    std::atomic<float>* freezeValue;
+    std::atomic<float>* rightOffsetValue;
+    
+    // The host tempo as last seen on the playhead, 120 bpm in 4/4 until a host
+    // reports one. The synced delay time is only worked out again when the
+    // tempo, time signature or division changes.
+    double hostBpm;
+    int hostNumerator, hostDenominator;
+    double syncedBpm;
+    int syncedNumerator, syncedDenominator, syncedDivision;
+    float syncedDelayLength;
+    bool firstBlock;
+    
+    // Idle detection. Once the input has stayed below silenceThreshold for as
+    // long as the loudest signal the loop could hold takes to decay below it,
+    // the delay line is left alone until the input comes back.
+    static constexpr float silenceThreshold = 3.1623e-5f;  // -90 dB
+    juce::int64 silentSamples;
+    float inputPeakHold;
+    bool idle;
+    static double getDecaySeconds (double delaySeconds, double feedback, double longestTapSeconds, double peak);
+    
+    // the levels of the block being processed, pushed to meterQueue at its end
+    MeterAccumulator inputMeter, wetMeter, loopMeter;
+    
+    // the values the audio thread last applied
+    float delayLength;
+    float rightOffset;
+    float crossLength;
+    int interpolation;
+    int delayMode;
+    
+    // dry, wet and feedback are ramped per sample towards their parameter values
+    static constexpr double parameterRampSeconds = 0.02;
+    ParameterRamp dryMixRamp;
+    ParameterRamp wetMixRamp;
+    ParameterRamp feedbackRamp;
+    
+    // tone and saturation inside the feedback loop, per channel filter states
+    // with the low cut's first and the high cut's after them
+    FeedbackFilter feedbackFilter;
+    float lowCut, highCut, saturation;
+    juce::HeapBlock<float> feedbackFilterState;
+    
+    // the oversampled drive on the feedback, driving is set while it runs.
+    // The last getLatency() frames before the write head then only hold their
+    // input, it adds their feedback as it comes out.
+    FeedbackDrive feedbackDrive;
+    float drive;
+    bool driving;
+    
+    // The routing of the feedback between the channels. A chunk's feedback
+    // is gathered in feedbackBuffer, laid out like the delay buffer, and mixed
+    // once every line has been read, before it is added to the input already
+    // written, see mixFeedback().
+    FeedbackMatrix feedbackMatrix;
+    int feedbackMatrixMode;
+    float crossFeed;
+    juce::AudioSampleBuffer feedbackBuffer;
+    
+    // the reverb next to the delay, fed the mono input and mixed into the
+    // output at its own ramped level
+    FdnReverb fdnReverb;
+    ParameterRamp reverbLevelRamp;
+    
+    // turns the delay and the reverb down under the input, or under the
+    // sidechain when duckSidechain is set and the host connects one
+    Ducker ducker;
+    bool duckSidechain;
+    
+    // circular buffer variables, read heads sit at a position plus a fraction of a sample.
+    // The buffer has a line per channel, or a single line with a lane per
+    // channel when interleaved, and only holds the configured maximum delay.
+    // It is replaced by one built on the allocator's thread when that changes.
+    // The write head is shared, every channel writes the same frame.
+    bool interleavedDelayStore;
+    int numDelayChannels;
+    int numDelayLines;
+    int numDelayLanes;
+    std::unique_ptr<juce::AudioSampleBuffer> delayBuffer;
+    DelayBufferAllocator delayBufferAllocator;
     int delayBufferLength;
-    int delayReadPosition;
     int delayWritePosition;
-    int prevDelayReadPosition;
+    
+    // Every channel has a main read head of its own, so the right of each
+    // channel pair can be offset from the left, see getChannelDelaySamples().
+    // A head fades or glides to a new delay time on its own, and when frozen
+    // loops its own length of the line.
+    struct ReadHead
+    {
+        // the delay in samples the head is heading for, and in glide mode where it is now
+        double delaySamples = 0.0;
+        double glideDelaySamples = 0.0;
+        double glideStep = 0.0;
+        int position = 0;
+        float fraction = 0.0f;
+        int prevPosition = 0;
+        float prevFraction = 0.0f;
+        
+        // crossfade, the old position keeps reading from delayBuffer while fading out
+        int crossPosition = 0;
+        float crossFraction = 0.0f;
+        int fadeCount = 0;
+        bool fading = false;
+        // a new delay that came in during the fade, the head moves once it is over
+        bool movePending = false;
+        
+        // freeze, see startFreeze()
+        int loopPosition = 0;
+        float loopFraction = 0.0f;
+        int loopCrossPosition = 0;
+        int loopLength = 1;
+        int loopFade = 0;
+        int loopFadeCount = 0;
+        bool loopFading = false;
+    };
+    ReadHead readHeads[maxNumChannels];
+    
+    // per channel state of the main and crossfade read heads' interpolators
+    juce::HeapBlock<float> interpolatorState;
+    int numInterpolatorStates;
+    
+    // the fastest a head glides, in samples of delay change per sample
+    static constexpr double maxGlideSpeed = 0.5;
+    
+    // swings the main and crossfade read heads back from where they are, in
+    // either mode, with offsets rendered a chunk at a time. Taps are left alone.
+    DelayLfo delayLfo;
+    
+    // A tap is a read head of its own that crossfades on time changes like the
+    // main head in crossfade mode, with ramped gain and pan. Taps only feed the
+    // output, the feedback comes from the main head.
+    struct DelayTap
+    {
+        // the parts that move while a block is processed, restored for every line
+        struct Heads
+        {
+            int position = 0;
+            int crossPosition = 0;
+            int fadeCount = 0;
+            bool fading = false;
+        };
+        
+        std::atomic<float>* timeValue = nullptr;
+        std::atomic<float>* gainValue = nullptr;
+        std::atomic<float>* panValue = nullptr;
+        float time = 0.0f;
+        Heads heads;
+        float fraction = 0.0f;
+        float crossFraction = 0.0f;
+        int prevPosition = 0;
+        float prevFraction = 0.0f;
+        ParameterRamp gainRamp;
+        ParameterRamp panRamp;
+    };
+    DelayTap taps[maxNumTaps];
+    
+    // the taps that are audible or fading out this block, silent ones are skipped
+    int liveTaps[maxNumTaps];
+    int numLiveTaps;
+    
+    // per line read and cross states of every tap's interpolator, sized in prepareToPlay
+    juce::HeapBlock<float> tapInterpolatorState;
+    
+    // the tap gains ramped per sample, one channel pair of left and right gains per tap
+    juce::AudioSampleBuffer tapGainBuffer;
+    
+    // the length of a crossfade of any head
     int crossCount;
-    int smoothCurrentCount;
-    int smoothWetCurrentCount;
-    bool smoothFlagGlobal;
-    std::vector<std::vector<float> > smoothValue;
+    
+    // Freeze stops the writes and plays the line round as a loop, from where
+    // each read head was to loopEnd. A loop head jumps back by its loopLength
+    // each time it comes loopFade frames short of the end, and the position it
+    // left fades out over loopFade frames like a crossfade of the read head.
+    bool frozen;
+    int loopEnd;
+    
+    // working memory for the vectorised delay loop and the parameter ramps, sized in prepareToPlay
+    enum ScratchChannels
+    {
+        readScratch = 0,
+        crossReadScratch,
+        fadeScratch,
+        newGainScratch,
+        oldGainScratch,
+        dryRampScratch,
+        wetRampScratch,
+        feedbackRampScratch,
+        interleavedScratch,
+        tapReadScratch,
+        tapMixScratch,
+        feedbackLoopScratch,
+        saturationScratch,
+        driveScratch,
+        loopInputScratch,
+        silentInputScratch,
+        reverbInputScratch,
+        reverbLevelScratch,
+        duckGainScratch,
+        lfoOffsetScratch,
+        numScratchChannels
+    };
+    juce::AudioSampleBuffer scratchBuffer;
+    int maxChunkFrames;
+    
+    template <typename Interpolator>
+    void processDelayLine (juce::AudioSampleBuffer& buffer);
+    template <typename Interpolator>
+    void readLanes (const float* delayData, const int* positions, const float* fractions,
+                    float* dest, int numFrames, int numLanes, float* state) const;
+    template <typename Interpolator>
+    void readModulated (const float* delayData, const int* positions, const float* fractions, const float* offsets,
+                        float* dest, int numFrames, int numLanes, float* state) const;
+    
+    int delayBufferSizeFor (float maxDelaySeconds) const;
+    std::unique_ptr<juce::AudioSampleBuffer> swapInDelayBuffer (std::unique_ptr<juce::AudioSampleBuffer> newBuffer);
+    void carryDelayHistory (const juce::AudioSampleBuffer& oldBuffer, int oldLength);
+    void resetDelayLine();
+    void primeFeedbackDrive();
+    void flushFeedbackDrive();
+    int framesBeforeUnmixedReads (int driveLatency) const;
+    void addFeedback (int line, const float* feedback, int writePosition, int numFrames);
+    void mixFeedback (int writePosition, int numFrames);
+    void startFreeze();
+    void stopFreeze();
+    double getLoopDelaySamples (const ReadHead& head) const;
+    double getChannelDelaySamples (int channel) const;
+    void setReadPositionsForDelay();
+    bool isAnyHeadFading() const;
+    void setTapPosition (DelayTap& tap);
+    void updateHostTempo();
+    float getDelayTime();
+    double clampDelaySamples (double samples) const;
+    void positionForDelay (double samples, int& position, float& fraction) const;
+    int windowStart (int readPosition) const;
+    int wrapPosition (int position) const;
+    int distanceToWriteHead (int readPosition, int writePosition) const;
     
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DynamicDelayAudioProcessor)
@@ -0,0 +1,594 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+//==============================================================================
+// Heap allocations made while a block is being processed are counted, so a
+// regression that makes the audio thread allocate shows up in the report.
+static std::atomic<bool> countingAllocations { false };
+static std::atomic<juce::int64> allocationCount { 0 };
+
+static inline void countAllocation() noexcept
+{
+    if (countingAllocations.load (std::memory_order_relaxed))
+        allocationCount.fetch_add (1, std::memory_order_relaxed);
+}
+
+#if defined (__GLIBC__)
+// glibc lets us interpose malloc itself, which also catches JUCE's HeapBlock
+// and the default operator new.
+extern "C" void* __libc_malloc (size_t);
+extern "C" void* __libc_calloc (size_t, size_t);
+extern "C" void* __libc_realloc (void*, size_t);
+
+extern "C" void* malloc (size_t size)                  { countAllocation(); return __libc_malloc (size); }
+extern "C" void* calloc (size_t count, size_t size)    { countAllocation(); return __libc_calloc (count, size); }
+extern "C" void* realloc (void* ptr, size_t size)      { countAllocation(); return __libc_realloc (ptr, size); }
+
+static const char* const allocationsColumn = "allocations_per_block";
+#else
+// Elsewhere malloc cannot be replaced portably, so only operator new is
+// counted. HeapBlock and other direct malloc calls go unseen, and the
+// column is named for what it holds.
+static const char* const allocationsColumn = "new_calls_per_block";
+
+void* operator new (std::size_t size)
+{
+    countAllocation();
+
+    if (void* p = std::malloc (size > 0 ? size : 1))
+        return p;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[] (std::size_t size)                 { return operator new (size); }
+void operator delete (void* p) noexcept                 { std::free (p); }
+void operator delete[] (void* p) noexcept               { std::free (p); }
+void operator delete (void* p, std::size_t) noexcept    { std::free (p); }
+void operator delete[] (void* p, std::size_t) noexcept  { std::free (p); }
+#endif
+
+//==============================================================================
+struct BenchmarkCase
+{
+    int blockSize;
+    int numChannels;
+    float crossLength;
+    int interpolation;
+    int delayMode;
+    bool interleaved;
+    int numTaps;
+    int feedbackStage;
+};
+
+struct BenchmarkResult
+{
+    BenchmarkCase config;
+    int numBlocks;
+    double nsPerSample;
+    double meanBlockMicroseconds;
+    double worstBlockMicroseconds;
+    double allocationsPerBlock;
+    double cpuLoad;
+};
+
+static const char* const usage =
+    "Usage: DynamicDelayBenchmark [options]\n"
+    "\n"
+    "  --format <csv|json>       report format (default csv)\n"
+    "  --output|-o <file>        write the report to a file instead of stdout\n"
+    "  --seconds <n>             seconds of audio processed per case (default 4)\n"
+    "  --sample-rate <hz>        sample rate (default 48000)\n"
+    "  --quick                   only run a reduced set of cases\n"
+    "  --interpolation <name>    only run one interpolation kernel (linear, hermite, lagrange, allpass)\n"
+    "  --mode <name>             only run one delay mode (crossfade, glide)\n"
+    "  --layout <name>           delay store layout (planar, interleaved or both, default planar)\n"
+    "  --compare-layouts         planar against interleaved on 2, 8 and 16 channels\n"
+    "  --taps <n>                number of active taps (default 0)\n"
+    "  --compare-taps            0 to 16 taps on stereo\n"
+    "  --feedback <name>         feedback loop (plain, filtered, saturated, drive1x, drive2x, drive4x,\n"
+    "                            drive8x, pingpong, householder, reverb8, reverb16, ducked,\n"
+    "                            chorus, frozen, default plain)\n"
+    "  --compare-feedback        the feedback loops against each other\n"
+    "  --decay                   cost of every second of a 60 s decay instead of the usual cases\n";
+
+static void setParameterValue (DynamicDelayAudioProcessor& processor, int index, float value)
+{
+    juce::RangedAudioParameter* parameter = processor.parameters.getParameter (DynamicDelayAudioProcessor::getParameterID (index));
+    parameter->setValueNotifyingHost (parameter->convertTo0to1 (value));
+}
+
+// what runs inside the feedback loop
+enum FeedbackStages
+{
+    plainFeedback = 0,      // the single multiply
+    filteredFeedback,       // low and high cut
+    saturatedFeedback,      // low and high cut, then the saturator
+    drive1xFeedback,        // low and high cut, then the drive at each oversampling factor
+    drive2xFeedback,
+    drive4xFeedback,
+    drive8xFeedback,
+    pingPongFeedback,       // the single multiply, then each feedback matrix
+    householderFeedback,
+    reverb8Feedback,        // the single multiply, with the reverb on 8 and on 16 lines next to it
+    reverb16Feedback,
+    duckedFeedback,         // the single multiply, with the wet signal ducked under the input
+    chorusFeedback,         // the single multiply, with the LFO moving the read head
+    frozenFeedback,         // no loop at all, the line frozen and played round
+    numFeedbackStages
+};
+
+static const char* const feedbackStageNames[] = { "plain", "filtered", "saturated", "drive1x", "drive2x", "drive4x", "drive8x",
+                                                   "pingpong", "householder", "reverb8", "reverb16", "ducked", "chorus", "frozen" };
+
+// the delay times cycled through mid-stream, each change starts a crossfade
+static const float delaySweep[] = { 0.1f, 0.35f, 0.8f, 1.5f };
+
+static BenchmarkResult runCase (const BenchmarkCase& config, double sampleRate, double seconds)
+{
+    DynamicDelayAudioProcessor processor;
+    processor.setPlayConfigDetails (config.numChannels, config.numChannels, sampleRate, config.blockSize);
+    processor.setInterleavedDelayStore (config.interleaved);
+
+    setParameterValue (processor, DynamicDelayAudioProcessor::delayLengthParam, delaySweep[0]);
+    setParameterValue (processor, DynamicDelayAudioProcessor::dryMixParam, 1.0f);
+    setParameterValue (processor, DynamicDelayAudioProcessor::wetMixParam, 0.5f);
+    setParameterValue (processor, DynamicDelayAudioProcessor::feedbackParam, 0.75f);
+    setParameterValue (processor, DynamicDelayAudioProcessor::crossLengthParam, config.crossLength);
+    setParameterValue (processor, DynamicDelayAudioProcessor::interpolationParam, (float) config.interpolation);
+    setParameterValue (processor, DynamicDelayAudioProcessor::delayModeParam, (float) config.delayMode);
+    setParameterValue (processor, DynamicDelayAudioProcessor::numTapsParam, (float) config.numTaps);
+
+    if (config.feedbackStage >= filteredFeedback && config.feedbackStage <= drive8xFeedback)
+    {
+        setParameterValue (processor, DynamicDelayAudioProcessor::lowCutParam, 150.0f);
+        setParameterValue (processor, DynamicDelayAudioProcessor::highCutParam, 6000.0f);
+    }
+
+    if (config.feedbackStage == saturatedFeedback)
+        setParameterValue (processor, DynamicDelayAudioProcessor::saturationParam, 0.5f);
+
+    if (config.feedbackStage >= drive1xFeedback && config.feedbackStage <= drive8xFeedback)
+    {
+        setParameterValue (processor, DynamicDelayAudioProcessor::driveParam, 0.5f);
+        setParameterValue (processor, DynamicDelayAudioProcessor::oversamplingParam, (float) (config.feedbackStage - drive1xFeedback));
+    }
+
+    if (config.feedbackStage == pingPongFeedback)
+        setParameterValue (processor, DynamicDelayAudioProcessor::feedbackMatrixParam, (float) FeedbackMatrix::pingPong);
+
+    if (config.feedbackStage == householderFeedback)
+        setParameterValue (processor, DynamicDelayAudioProcessor::feedbackMatrixParam, (float) FeedbackMatrix::householder);
+
+    if (config.feedbackStage == reverb8Feedback || config.feedbackStage == reverb16Feedback)
+        setParameterValue (processor, DynamicDelayAudioProcessor::reverbParam,
+                           (float) (config.feedbackStage == reverb8Feedback ? FdnReverb::hadamard8 : FdnReverb::hadamard16));
+
+    if (config.feedbackStage == duckedFeedback)
+        setParameterValue (processor, DynamicDelayAudioProcessor::duckAmountParam, 0.8f);
+
+    if (config.feedbackStage == chorusFeedback)
+    {
+        setParameterValue (processor, DynamicDelayAudioProcessor::lfoRateParam, 0.8f);
+        setParameterValue (processor, DynamicDelayAudioProcessor::lfoDepthParam, 3.0f);
+    }
+
+    if (config.feedbackStage == frozenFeedback)
+        setParameterValue (processor, DynamicDelayAudioProcessor::freezeParam, 1.0f);
+
+    // taps spread over the sweep, with alternating pans
+    for (int t = 0; t < config.numTaps; ++t)
+    {
+        setParameterValue (processor, DynamicDelayAudioProcessor::getTapParameterIndex (t, DynamicDelayAudioProcessor::tapTimeParam), 0.05f + 0.11f * (float) t);
+        setParameterValue (processor, DynamicDelayAudioProcessor::getTapParameterIndex (t, DynamicDelayAudioProcessor::tapPanParam), (t & 1) != 0 ? 0.5f : -0.5f);
+    }
+
+    processor.prepareToPlay (sampleRate, config.blockSize);
+
+    juce::AudioSampleBuffer source (config.numChannels, config.blockSize);
+    juce::AudioSampleBuffer buffer (config.numChannels, config.blockSize);
+    juce::MidiBuffer midiMessages;
+    juce::Random random (0x5eed);
+
+    for (int channel = 0; channel < config.numChannels; ++channel)
+        for (int i = 0; i < config.blockSize; ++i)
+            source.setSample (channel, i, random.nextFloat() * 2.0f - 1.0f);
+
+    const int numBlocks = juce::jmax (1, (int) (seconds * sampleRate / config.blockSize));
+    const int blocksPerChange = juce::jmax (1, (int) (0.25 * sampleRate / config.blockSize));
+    const int numWarmupBlocks = juce::jmin (numBlocks, 16);
+
+    juce::int64 totalTicks = 0;
+    juce::int64 worstTicks = 0;
+    juce::int64 allocations = 0;
+    int sweepIndex = 0;
+
+    for (int block = -numWarmupBlocks; block < numBlocks; ++block)
+    {
+        if (block > 0 && block % blocksPerChange == 0)
+        {
+            sweepIndex = (sweepIndex + 1) % juce::numElementsInArray (delaySweep);
+            setParameterValue (processor, DynamicDelayAudioProcessor::delayLengthParam, delaySweep[sweepIndex]);
+
+            // and one tap moves with every change, so tap crossfades are part of the cost
+            if (config.numTaps > 0)
+                setParameterValue (processor, DynamicDelayAudioProcessor::getTapParameterIndex (block / blocksPerChange % config.numTaps, DynamicDelayAudioProcessor::tapTimeParam),
+                                   delaySweep[sweepIndex] * 0.5f);
+        }
+
+        buffer.makeCopyOf (source, true);
+
+        allocationCount.store (0);
+        countingAllocations.store (true);
+        const juce::int64 start = juce::Time::getHighResolutionTicks();
+
+        processor.processBlock (buffer, midiMessages);
+
+        const juce::int64 elapsed = juce::Time::getHighResolutionTicks() - start;
+        countingAllocations.store (false);
+
+        if (block < 0)
+            continue;
+
+        totalTicks += elapsed;
+        worstTicks = juce::jmax (worstTicks, elapsed);
+        allocations += allocationCount.load();
+    }
+
+    processor.releaseResources();
+
+    const double totalSeconds = juce::Time::highResolutionTicksToSeconds (totalTicks);
+    const double numSamples = (double) numBlocks * config.blockSize * config.numChannels;
+
+    BenchmarkResult result;
+    result.config = config;
+    result.numBlocks = numBlocks;
+    result.nsPerSample = totalSeconds * 1.0e9 / numSamples;
+    result.meanBlockMicroseconds = totalSeconds * 1.0e6 / numBlocks;
+    result.worstBlockMicroseconds = juce::Time::highResolutionTicksToSeconds (worstTicks) * 1.0e6;
+    result.allocationsPerBlock = (double) allocations / numBlocks;
+    result.cpuLoad = totalSeconds / ((double) numBlocks * config.blockSize / sampleRate);
+    return result;
+}
+
+//==============================================================================
+static const char* layoutName (bool interleaved)
+{
+    return interleaved ? "interleaved" : "planar";
+}
+
+static juce::String toCsv (const juce::Array<BenchmarkResult>& results)
+{
+    juce::String csv ("block_size,channels,cross_seconds,interpolation,mode,layout,taps,feedback,blocks,ns_per_sample,mean_block_us,worst_block_us,");
+    csv << allocationsColumn << ",cpu_load\n";
+
+    for (const BenchmarkResult& r : results)
+        csv << r.config.blockSize << ',' << r.config.numChannels << ',' << r.config.crossLength << ','
+            << DelayInterpolation::getNames()[r.config.interpolation] << ',' << DynamicDelayAudioProcessor::getDelayModeNames()[r.config.delayMode] << ','
+            << layoutName (r.config.interleaved) << ',' << r.config.numTaps << ','
+            << feedbackStageNames[r.config.feedbackStage] << ','
+            << r.numBlocks << ',' << r.nsPerSample << ',' << r.meanBlockMicroseconds << ','
+            << r.worstBlockMicroseconds << ',' << r.allocationsPerBlock << ',' << r.cpuLoad << '\n';
+
+    return csv;
+}
+
+static juce::String toJson (const juce::Array<BenchmarkResult>& results, double sampleRate)
+{
+    juce::Array<juce::var> cases;
+
+    for (const BenchmarkResult& r : results)
+    {
+        juce::DynamicObject::Ptr object (new juce::DynamicObject());
+        object->setProperty ("block_size", r.config.blockSize);
+        object->setProperty ("channels", r.config.numChannels);
+        object->setProperty ("cross_seconds", r.config.crossLength);
+        object->setProperty ("interpolation", DelayInterpolation::getNames()[r.config.interpolation]);
+        object->setProperty ("mode", DynamicDelayAudioProcessor::getDelayModeNames()[r.config.delayMode]);
+        object->setProperty ("layout", layoutName (r.config.interleaved));
+        object->setProperty ("taps", r.config.numTaps);
+        object->setProperty ("feedback", feedbackStageNames[r.config.feedbackStage]);
+        object->setProperty ("blocks", r.numBlocks);
+        object->setProperty ("ns_per_sample", r.nsPerSample);
+        object->setProperty ("mean_block_us", r.meanBlockMicroseconds);
+        object->setProperty ("worst_block_us", r.worstBlockMicroseconds);
+        object->setProperty (allocationsColumn, r.allocationsPerBlock);
+        object->setProperty ("cpu_load", r.cpuLoad);
+        cases.add (juce::var (object.get()));
+    }
+
+    juce::DynamicObject::Ptr report (new juce::DynamicObject());
+    report->setProperty ("benchmark", "processBlock");
+    report->setProperty ("sample_rate", sampleRate);
+    report->setProperty ("cases", cases);
+    return juce::JSON::toString (juce::var (report.get())) + "\n";
+}
+
+//==============================================================================
+// One second of noise followed by 60 s of silence. The delay time moves every
+// quarter second and takes half a second to glide there, so the line never
+// goes idle and the repeats keep recirculating into the denormal range. The
+// cost of each second should stay flat while they die away.
+struct DecayResult
+{
+    float feedback;
+    int second;
+    double nsPerSample;
+    double cpuLoad;
+};
+
+static const float decayFeedbacks[] = { 0.5f, 0.9f, 0.995f };
+static const float decaySweep[] = { 0.01f, 0.02f, 0.03f, 0.05f };
+
+static juce::Array<DecayResult> runDecay (double sampleRate, int blockSize, int numChannels)
+{
+    juce::Array<DecayResult> results;
+
+    for (float feedback : decayFeedbacks)
+    {
+        DynamicDelayAudioProcessor processor;
+        processor.setPlayConfigDetails (numChannels, numChannels, sampleRate, blockSize);
+
+        setParameterValue (processor, DynamicDelayAudioProcessor::delayLengthParam, decaySweep[0]);
+        setParameterValue (processor, DynamicDelayAudioProcessor::wetMixParam, 0.5f);
+        setParameterValue (processor, DynamicDelayAudioProcessor::feedbackParam, feedback);
+        setParameterValue (processor, DynamicDelayAudioProcessor::crossLengthParam, 0.5f);
+        setParameterValue (processor, DynamicDelayAudioProcessor::delayModeParam, (float) DynamicDelayAudioProcessor::glideMode);
+        setParameterValue (processor, DynamicDelayAudioProcessor::interpolationParam, (float) DelayInterpolation::allpass);
+        setParameterValue (processor, DynamicDelayAudioProcessor::lowCutParam, 100.0f);
+        setParameterValue (processor, DynamicDelayAudioProcessor::highCutParam, 8000.0f);
+        processor.prepareToPlay (sampleRate, blockSize);
+
+        juce::AudioSampleBuffer buffer (numChannels, blockSize);
+        juce::MidiBuffer midiMessages;
+        juce::Random random (0x5eed);
+
+        const int blocksPerSecond = juce::jmax (1, (int) (sampleRate / blockSize));
+        const int blocksPerChange = juce::jmax (1, blocksPerSecond / 4);
+        int sweepIndex = 0;
+
+        for (int second = 0; second <= 60; ++second)
+        {
+            juce::int64 ticks = 0;
+
+            for (int block = 0; block < blocksPerSecond; ++block)
+            {
+                if (block % blocksPerChange == 0)
+                {
+                    sweepIndex = (sweepIndex + 1) % juce::numElementsInArray (decaySweep);
+                    setParameterValue (processor, DynamicDelayAudioProcessor::delayLengthParam, decaySweep[sweepIndex]);
+                }
+
+                for (int channel = 0; channel < numChannels; ++channel)
+                    for (int i = 0; i < blockSize; ++i)
+                        buffer.setSample (channel, i, second == 0 ? random.nextFloat() * 2.0f - 1.0f : 0.0f);
+
+                const juce::int64 start = juce::Time::getHighResolutionTicks();
+                processor.processBlock (buffer, midiMessages);
+                ticks += juce::Time::getHighResolutionTicks() - start;
+            }
+
+            const double seconds = juce::Time::highResolutionTicksToSeconds (ticks);
+            const double numFrames = (double) blocksPerSecond * blockSize;
+            results.add ({ feedback, second, seconds * 1.0e9 / (numFrames * numChannels), seconds / (numFrames / sampleRate) });
+        }
+
+        processor.releaseResources();
+        std::cerr << "." << std::flush;
+    }
+
+    std::cerr << std::endl;
+    return results;
+}
+
+static juce::String decayToCsv (const juce::Array<DecayResult>& results)
+{
+    juce::String csv ("feedback,second,ns_per_sample,cpu_load\n");
+
+    for (const DecayResult& r : results)
+        csv << r.feedback << ',' << r.second << ',' << r.nsPerSample << ',' << r.cpuLoad << '\n';
+
+    return csv;
+}
+
+static juce::String decayToJson (const juce::Array<DecayResult>& results, double sampleRate)
+{
+    juce::Array<juce::var> seconds;
+
+    for (const DecayResult& r : results)
+    {
+        juce::DynamicObject::Ptr object (new juce::DynamicObject());
+        object->setProperty ("feedback", r.feedback);
+        object->setProperty ("second", r.second);
+        object->setProperty ("ns_per_sample", r.nsPerSample);
+        object->setProperty ("cpu_load", r.cpuLoad);
+        seconds.add (juce::var (object.get()));
+    }
+
+    juce::DynamicObject::Ptr report (new juce::DynamicObject());
+    report->setProperty ("benchmark", "decay");
+    report->setProperty ("sample_rate", sampleRate);
+    report->setProperty ("seconds", seconds);
+    return juce::JSON::toString (juce::var (report.get())) + "\n";
+}
+
+static void writeReport (const juce::ArgumentList& args, const juce::String& report)
+{
+    if (args.containsOption ("--output|-o"))
+    {
+        const juce::File outputFile = args.getFileForOption ("--output|-o");
+
+        if (! outputFile.replaceWithText (report))
+            juce::ConsoleApplication::fail ("Couldn't write " + outputFile.getFullPathName());
+    }
+    else
+    {
+        std::cout << report;
+    }
+}
+
+//==============================================================================
+static int runBenchmarks (const juce::ArgumentList& args)
+{
+    const juce::String format = args.containsOption ("--format") ? args.getValueForOption ("--format") : juce::String ("csv");
+    const double seconds = args.containsOption ("--seconds") ? args.getValueForOption ("--seconds").getDoubleValue() : 4.0;
+    const double sampleRate = args.containsOption ("--sample-rate") ? args.getValueForOption ("--sample-rate").getDoubleValue() : 48000.0;
+    const bool quick = args.containsOption ("--quick");
+    const bool compareLayouts = args.containsOption ("--compare-layouts");
+    const bool compareTaps = args.containsOption ("--compare-taps");
+    const bool compareFeedback = args.containsOption ("--compare-feedback");
+
+    if (format != "csv" && format != "json")
+        juce::ConsoleApplication::fail ("Unknown format '" + format + "', expected csv or json");
+
+    if (seconds <= 0.0 || sampleRate <= 0.0)
+        juce::ConsoleApplication::fail ("--seconds and --sample-rate must be positive");
+
+    if (args.containsOption ("--decay"))
+    {
+        const juce::Array<DecayResult> results = runDecay (sampleRate, 512, 2);
+        writeReport (args, format == "json" ? decayToJson (results, sampleRate) : decayToCsv (results));
+        return 0;
+    }
+
+    juce::Array<int> blockSizes = quick ? juce::Array<int> { 64, 512 }
+                                        : juce::Array<int> { 16, 32, 64, 128, 256, 512, 1024, 2048, 4096 };
+    juce::Array<int> channelCounts = quick ? juce::Array<int> { 2 } : juce::Array<int> { 1, 2, 4, 8, 12 };
+    juce::Array<float> crossLengths = quick ? juce::Array<float> { 2.0f } : juce::Array<float> { 0.01f, 0.25f, 1.0f, 2.0f };
+    juce::Array<bool> layouts { false };
+
+    if (args.containsOption ("--layout"))
+    {
+        const juce::String name = args.getValueForOption ("--layout");
+
+        if (name == "both")
+            layouts = { false, true };
+        else if (name == "planar" || name == "interleaved")
+            layouts = { name == "interleaved" };
+        else
+            juce::ConsoleApplication::fail ("Unknown layout '" + name + "', expected planar, interleaved or both");
+    }
+
+    if (compareLayouts)
+    {
+        blockSizes = quick ? juce::Array<int> { 512 } : juce::Array<int> { 64, 512, 4096 };
+        channelCounts = { 2, 8, 16 };
+        crossLengths = { 1.0f };
+        layouts = { false, true };
+    }
+
+    juce::Array<int> tapCounts { args.containsOption ("--taps") ? args.getValueForOption ("--taps").getIntValue() : 0 };
+
+    if (tapCounts[0] < 0 || tapCounts[0] > DynamicDelayAudioProcessor::maxNumTaps)
+        juce::ConsoleApplication::fail ("--taps must be between 0 and " + juce::String (DynamicDelayAudioProcessor::maxNumTaps));
+
+    if (compareTaps)
+    {
+        blockSizes = quick ? juce::Array<int> { 512 } : juce::Array<int> { 64, 512 };
+        channelCounts = { 2 };
+        crossLengths = { 1.0f };
+        tapCounts = { 0, 1, 2, 4, 8, 16 };
+    }
+
+    juce::Array<int> feedbackStages { plainFeedback };
+
+    if (args.containsOption ("--feedback"))
+    {
+        const juce::String name = args.getValueForOption ("--feedback");
+        feedbackStages.clear();
+
+        for (int i = 0; i < numFeedbackStages; ++i)
+            if (name == feedbackStageNames[i])
+                feedbackStages.add (i);
+
+        if (feedbackStages.isEmpty())
+            juce::ConsoleApplication::fail ("Unknown feedback '" + name + "', expected plain, filtered, saturated, drive1x to drive8x, pingpong, householder, reverb8, reverb16, ducked, chorus or frozen");
+    }
+
+    if (compareFeedback)
+    {
+        blockSizes = quick ? juce::Array<int> { 512 } : juce::Array<int> { 64, 512 };
+        channelCounts = { 2, 8 };
+        crossLengths = { 1.0f };
+        feedbackStages = { plainFeedback, filteredFeedback, saturatedFeedback,
+                           drive1xFeedback, drive2xFeedback, drive4xFeedback, drive8xFeedback,
+                           pingPongFeedback, householderFeedback, reverb8Feedback, reverb16Feedback, duckedFeedback, chorusFeedback, frozenFeedback };
+    }
+
+    juce::Array<int> interpolations;
+
+    if (args.containsOption ("--interpolation"))
+    {
+        const juce::String name = args.getValueForOption ("--interpolation");
+        const juce::StringArray names = DelayInterpolation::getNames();
+
+        for (int i = 0; i < names.size(); ++i)
+            if (names[i].containsIgnoreCase (name))
+                interpolations.add (i);
+
+        if (interpolations.size() != 1)
+            juce::ConsoleApplication::fail ("Unknown interpolation '" + name + "'");
+    }
+    else
+    {
+        for (int i = 0; i < DelayInterpolation::numTypes; ++i)
+            interpolations.add (i);
+    }
+
+    const juce::StringArray delayModeNames = DynamicDelayAudioProcessor::getDelayModeNames();
+    juce::Array<int> delayModes;
+
+    for (int i = 0; i < delayModeNames.size(); ++i)
+        if (! args.containsOption ("--mode") || args.getValueForOption ("--mode") == delayModeNames[i])
+            delayModes.add (i);
+
+    if (delayModes.isEmpty())
+        juce::ConsoleApplication::fail ("Unknown mode '" + args.getValueForOption ("--mode") + "'");
+
+    juce::Array<BenchmarkResult> results;
+
+    for (int blockSize : blockSizes)
+        for (int numChannels : channelCounts)
+            for (float crossLength : crossLengths)
+                for (int interpolation : interpolations)
+                    for (int delayMode : delayModes)
+                        for (bool interleaved : layouts)
+                            for (int numTaps : tapCounts)
+                                for (int feedbackStage : feedbackStages)
+                                {
+                                    results.add (runCase ({ blockSize, numChannels, crossLength, interpolation, delayMode, interleaved, numTaps, feedbackStage },
+                                                          sampleRate, seconds));
+                                    std::cerr << "." << std::flush;
+                                }
+
+    std::cerr << std::endl;
+
+    writeReport (args, format == "json" ? toJson (results, sampleRate) : toCsv (results));
+    return 0;
+}
+
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ArgumentList args (argc, argv);
+
+    if (args.containsOption ("--help|-h"))
+    {
+        std::cout << usage;
+        return 0;
+    }
+
+    return juce::ConsoleApplication::invokeCatchingFailures ([&args] { return runBenchmarks (args); });
+}
@@ -0,0 +1,233 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+#include <algorithm>
+#include <iostream>
+
+//==============================================================================
+struct AutomationEvent
+{
+    juce::int64 samplePosition;
+    int parameterIndex;
+    float value;
+};
+
+static const char* const usage =
+    "Usage: DynamicDelayRender --input <in.wav> --output <out.wav> [options]\n"
+    "\n"
+    "  --block-size|-b <n>       samples per processBlock call (default 512)\n"
+    "  --tail <seconds>          extra silence rendered after the input (default 0)\n"
+    "  --set <param>=<value>     initial parameter value, may be repeated\n"
+    "  --automation|-a <file>    CSV of 'seconds, parameter, value' lines\n"
+    "\n"
+    "Parameters may be given by index, by ID (delayLength, dryMix, wetMix, feedback, crossLength,\n"
+    "interpolation, delayMode, maxDelay, numTaps, sync, division, lowCut, highCut, saturation, drive,\n"
+    "oversampling, feedbackMatrix, crossFeed, reverb, reverbSize, reverbDecay, reverbLevel, duckAmount,\n"
+    "duckAttack, duckRelease, duckSidechain, lfoShape, lfoRate, lfoDepth, lfoPhase, freeze, rightOffset,\n"
+    "tap1Time, tap1Gain, tap1Pan ... tap16Pan) or by name (delay, dry mix, wet mix, feedback, cross,\n"
+    "interpolation, mode, max delay, taps, sync, division, low cut, high cut, saturation, drive,\n"
+    "oversampling, feedback matrix, cross-feed, reverb, reverb size, reverb decay, reverb level, duck,\n"
+    "duck attack, duck release, duck sidechain, lfo shape, lfo rate, lfo depth, lfo phase, freeze,\n"
+    "right offset, tap 1 time ...).\n"
+    "Choice parameters take the index of the choice, e.g. interpolation=0 for linear, delayMode=1 for\n"
+    "glide, division=5 for 1/4, oversampling=3 for 8x, feedbackMatrix=1 for ping-pong, reverb=2 for\n"
+    "16 lines Hadamard or lfoShape=2 for random. Switches take 0 or 1.\n"
+    "There is no sidechain offline, the ducking follows the input.\n"
+    "Synced delays run at 120 bpm in 4/4, there is no host tempo offline.\n";
+
+static int findParameterIndex (DynamicDelayAudioProcessor& processor, const juce::String& name)
+{
+    if (name.isNotEmpty() && name.containsOnly ("0123456789"))
+        return name.getIntValue();
+
+    for (int i = 0; i < DynamicDelayAudioProcessor::numParameters; ++i)
+    {
+        const juce::String parameterID (DynamicDelayAudioProcessor::getParameterID (i));
+
+        if (parameterID.equalsIgnoreCase (name)
+             || processor.parameters.getParameter (parameterID)->getName (64).equalsIgnoreCase (name))
+            return i;
+    }
+
+    return -1;
+}
+
+static int checkedParameterIndex (DynamicDelayAudioProcessor& processor, const juce::String& name)
+{
+    const int index = findParameterIndex (processor, name);
+
+    if (index < 0 || index >= DynamicDelayAudioProcessor::numParameters)
+        juce::ConsoleApplication::fail ("Unknown parameter '" + name + "'");
+
+    return index;
+}
+
+// values are given in the parameter's own units, e.g. seconds for the delay
+static void setParameterValue (DynamicDelayAudioProcessor& processor, int index, float value)
+{
+    juce::RangedAudioParameter* parameter = processor.parameters.getParameter (DynamicDelayAudioProcessor::getParameterID (index));
+    parameter->setValueNotifyingHost (parameter->convertTo0to1 (value));
+}
+
+static juce::Array<AutomationEvent> loadAutomation (const juce::File& file, DynamicDelayAudioProcessor& processor, double sampleRate)
+{
+    juce::Array<AutomationEvent> events;
+    juce::StringArray lines;
+    file.readLines (lines);
+
+    for (int l = 0; l < lines.size(); ++l)
+    {
+        const juce::String line = lines[l].upToFirstOccurrenceOf ("#", false, false).trim();
+
+        if (line.isEmpty())
+            continue;
+
+        juce::StringArray tokens;
+        tokens.addTokens (line, ",", "\"");
+        tokens.trim();
+
+        if (tokens.size() != 3)
+            juce::ConsoleApplication::fail (file.getFileName() + ":" + juce::String (l + 1)
+                                            + ": expected 'seconds, parameter, value'");
+
+        AutomationEvent event;
+        event.samplePosition = (juce::int64) (tokens[0].getDoubleValue() * sampleRate);
+        event.parameterIndex = checkedParameterIndex (processor, tokens[1]);
+        event.value = tokens[2].getFloatValue();
+        events.add (event);
+    }
+
+    std::stable_sort (events.begin(), events.end(), [] (const AutomationEvent& a, const AutomationEvent& b)
+    {
+        return a.samplePosition < b.samplePosition;
+    });
+
+    return events;
+}
+
+//==============================================================================
+static int render (const juce::ArgumentList& args)
+{
+    const juce::File inputFile = args.getExistingFileForOption ("--input|-i");
+    const juce::File outputFile = args.getFileForOption ("--output|-o");
+
+    const int blockSize = args.containsOption ("--block-size|-b") ? args.getValueForOption ("--block-size|-b").getIntValue() : 512;
+    const double tailSeconds = args.containsOption ("--tail") ? args.getValueForOption ("--tail").getDoubleValue() : 0.0;
+
+    if (blockSize < 1)
+        juce::ConsoleApplication::fail ("Block size must be at least 1");
+
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    std::unique_ptr<juce::AudioFormatReader> reader (formatManager.createReaderFor (inputFile));
+
+    if (reader == nullptr)
+        juce::ConsoleApplication::fail ("Couldn't read " + inputFile.getFullPathName());
+
+    const int numChannels = (int) reader->numChannels;
+    const double sampleRate = reader->sampleRate;
+    const int bitsPerSample = reader->usesFloatingPointData ? 32 : (int) reader->bitsPerSample;
+
+    DynamicDelayAudioProcessor processor;
+    processor.setNonRealtime (true);
+    processor.setPlayConfigDetails (numChannels, numChannels, sampleRate, blockSize);
+
+    // initial values are set before prepareToPlay so the read head starts in place
+    for (int i = 0; i < args.size() - 1; ++i)
+    {
+        if (args[i].text != "--set")
+            continue;
+
+        const juce::String assignment = args[i + 1].text;
+
+        if (! assignment.containsChar ('='))
+            juce::ConsoleApplication::fail ("Expected --set <param>=<value>, got '" + assignment + "'");
+
+        setParameterValue (processor, checkedParameterIndex (processor, assignment.upToFirstOccurrenceOf ("=", false, false).trim()),
+                           assignment.fromFirstOccurrenceOf ("=", false, false).getFloatValue());
+    }
+
+    juce::Array<AutomationEvent> events;
+
+    if (args.containsOption ("--automation|-a"))
+        events = loadAutomation (args.getExistingFileForOption ("--automation|-a"), processor, sampleRate);
+
+    processor.prepareToPlay (sampleRate, blockSize);
+
+    outputFile.deleteFile();
+    std::unique_ptr<juce::FileOutputStream> stream (outputFile.createOutputStream());
+
+    if (stream == nullptr)
+        juce::ConsoleApplication::fail ("Couldn't open " + outputFile.getFullPathName() + " for writing");
+
+    juce::WavAudioFormat wavFormat;
+    std::unique_ptr<juce::AudioFormatWriter> writer (wavFormat.createWriterFor (stream.get(), sampleRate, (unsigned int) numChannels,
+                                                                                bitsPerSample, {}, 0));
+
+    if (writer == nullptr)
+        juce::ConsoleApplication::fail ("Couldn't create a WAV writer for " + outputFile.getFullPathName());
+
+    stream.release(); // the writer owns the stream now
+
+    juce::AudioSampleBuffer buffer (numChannels, blockSize);
+    juce::MidiBuffer midiMessages;
+    const juce::int64 totalLength = reader->lengthInSamples + (juce::int64) (tailSeconds * sampleRate);
+    int nextEvent = 0;
+
+    for (juce::int64 position = 0; position < totalLength;)
+    {
+        while (nextEvent < events.size() && events.getReference (nextEvent).samplePosition <= position)
+        {
+            const AutomationEvent& event = events.getReference (nextEvent++);
+            setParameterValue (processor, event.parameterIndex, event.value);
+        }
+
+        // blocks are cut short at the next event so automation lands on the right sample
+        juce::int64 blockEnd = juce::jmin (position + blockSize, totalLength);
+
+        if (nextEvent < events.size())
+            blockEnd = juce::jmin (blockEnd, events.getReference (nextEvent).samplePosition);
+
+        const int numSamples = (int) (blockEnd - position);
+
+        buffer.setSize (numChannels, numSamples, false, false, true);
+        reader->read (&buffer, 0, numSamples, position, true, true);
+
+        processor.processBlock (buffer, midiMessages);
+
+        if (! writer->writeFromAudioSampleBuffer (buffer, 0, numSamples))
+            juce::ConsoleApplication::fail ("Write error on " + outputFile.getFullPathName());
+
+        position = blockEnd;
+    }
+
+    processor.releaseResources();
+
+    std::cout << "Rendered " << totalLength << " samples (" << numChannels << " ch, "
+              << sampleRate << " Hz, " << events.size() << " automation events) to "
+              << outputFile.getFullPathName() << std::endl;
+    return 0;
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ArgumentList args (argc, argv);
+
+    if (args.size() == 0 || args.containsOption ("--help|-h"))
+    {
+        std::cout << usage;
+        return 0;
+    }
+
+    return juce::ConsoleApplication::invokeCatchingFailures ([&args] { return render (args); });
+}